@@ -0,0 +1,76 @@
+#include <yaml-cpp/yaml.h>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+
+// 对比两份micro_bench --json的结果，ns/op变慢超过阈值的标为REGRESSION，有回退时返回1
+// 默认比各轮最小值(min_ns_per_op)，它对调度和频率干扰最不敏感；--median改比中位数
+// JSON是YAML的子集，直接用yaml-cpp读
+// 用法: bench_compare 基线.json 当前.json [阈值百分比，默认10] [--median]
+
+struct Entry {
+    double ns_per_op;
+};
+
+static std::map<std::string, Entry> loadResults(const std::string& path, bool median) {
+    std::map<std::string, Entry> entries;
+    auto root = YAML::LoadFile(path);
+    for (auto item : root["results"]) {
+        // 没有min_ns_per_op的旧文件退回中位数
+        auto value = !median && item["min_ns_per_op"] ? item["min_ns_per_op"] : item["ns_per_op"];
+        entries[item["name"].as<std::string>()] = {value.as<double>()};
+    }
+    return entries;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s baseline.json current.json [threshold_percent] [--median]\n", argv[0]);
+        return 2;
+    }
+    double threshold = 10.0;
+    bool median = false;
+    for (int i = 3; i < argc; i++) {
+        if (std::string(argv[i]) == "--median") {
+            median = true;
+        } else {
+            threshold = std::atof(argv[i]);
+        }
+    }
+    std::map<std::string, Entry> base, cur;
+    try {
+        base = loadResults(argv[1], median);
+        cur = loadResults(argv[2], median);
+    } catch (const YAML::Exception& e) {
+        fprintf(stderr, "can not read results: %s\n", e.what());
+        return 2;
+    }
+
+    int regressions = 0, improvements = 0;
+    printf("%-36s %12s %12s %9s  %s\n", "benchmark", "base ns/op", "cur ns/op", "delta", "");
+    for (auto& [name, c] : cur) {
+        auto it = base.find(name);
+        if (it == base.end()) {
+            printf("%-36s %12s %12.2f %9s  new\n", name.c_str(), "-", c.ns_per_op, "-");
+            continue;
+        }
+        double delta = (c.ns_per_op - it->second.ns_per_op) / it->second.ns_per_op * 100.0;
+        const char* flag = "";
+        if (delta > threshold) {
+            flag = "REGRESSION";
+            regressions++;
+        } else if (delta < -threshold) {
+            flag = "improved";
+            improvements++;
+        }
+        printf("%-36s %12.2f %12.2f %+8.1f%%  %s\n", name.c_str(), it->second.ns_per_op, c.ns_per_op, delta, flag);
+    }
+    for (auto& [name, b] : base) {
+        if (cur.count(name) == 0) {
+            printf("%-36s %12.2f %12s %9s  missing\n", name.c_str(), b.ns_per_op, "-", "-");
+        }
+    }
+    printf("%d regressions, %d improvements beyond %.1f%%\n", regressions, improvements, threshold);
+    return regressions > 0 ? 1 : 0;
+}
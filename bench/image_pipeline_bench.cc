@@ -0,0 +1,95 @@
+#include "image_pipeline.h"
+#include <chrono>
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+// 融合的ImagePipeline 与 原resnetPreprocess中OpenCV多次遍历实现的对比
+// 用法: image_pipeline_bench [宽] [高] [迭代次数]
+
+// 与src/app/resnet.cc中resnetPreprocess解码之后的步骤相同
+static std::vector<float> opencvChain(const cv::Mat& src) {
+    cv::Mat img;
+    cv::cvtColor(src, img, cv::COLOR_BGR2RGB);
+    int h = img.rows, w = img.cols;
+    int new_h, new_w;
+    if (h < w) {
+        new_h = 256;
+        new_w = static_cast<int>(w * 256.0 / h);
+    } else {
+        new_w = 256;
+        new_h = static_cast<int>(h * 256.0 / w);
+    }
+    cv::resize(img, img, cv::Size(new_w, new_h));
+    cv::Rect roi((img.cols - 224) / 2, (img.rows - 224) / 2, 224, 224);
+    cv::Mat crop = img(roi);
+    cv::Mat float_img;
+    crop.convertTo(float_img, CV_32F, 1.0 / 255.0);
+    std::vector<float> mean = {0.485f, 0.456f, 0.406f};
+    std::vector<float> std = {0.229f, 0.224f, 0.225f};
+    std::vector<cv::Mat> channels(3);
+    cv::split(float_img, channels);
+    for (int i = 0; i < 3; i++) {
+        channels[i] = (channels[i] - mean[i]) / std[i];
+    }
+    cv::merge(channels, float_img);
+    cv::split(float_img, channels);
+    std::vector<float> chw;
+    chw.reserve(3 * 224 * 224);
+    for (int i = 0; i < 3; i++) {
+        chw.insert(chw.end(), (float*)channels[i].datastart, (float*)channels[i].dataend);
+    }
+    return chw;
+}
+
+template <typename Fn>
+static double timeUs(int iters, Fn&& fn) {
+    fn();  // 预热
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iters;
+}
+
+int main(int argc, char** argv) {
+    int width = argc > 1 ? std::atoi(argv[1]) : 1920;
+    int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    int iters = argc > 3 ? std::atoi(argv[3]) : 200;
+
+    cv::Mat img(height, width, CV_8UC3);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    ImagePipelineCfg cfg;
+    cfg.resize_short = 256;
+    cfg.crop_h = cfg.crop_w = 224;
+    cfg.mean = {0.485f, 0.456f, 0.406f};
+    cfg.std = {0.229f, 0.224f, 0.225f};
+
+    std::vector<float> fused(3 * 224 * 224);
+    std::vector<uint16_t> fused_fp16(3 * 224 * 224);
+    ImagePipeline pipeline(cfg);
+    auto cfg_fp16 = cfg;
+    cfg_fp16.dtype = FLOAT16;
+    ImagePipeline pipeline_fp16(cfg_fp16);
+
+    std::vector<float> reference;
+    double cv_us = timeUs(iters, [&] { reference = opencvChain(img); });
+    double fused_us = timeUs(iters, [&] { pipeline.run(img.data, img.rows, img.cols, img.step, fused.data()); });
+    double fp16_us = timeUs(iters, [&] {
+        pipeline_fp16.run(img.data, img.rows, img.cols, img.step, fused_fp16.data());
+    });
+
+    double max_diff = 0.0;
+    for (size_t i = 0; i < fused.size() && i < reference.size(); i++) {
+        max_diff = std::max(max_diff, (double)std::fabs(fused[i] - reference[i]));
+    }
+    printf("input %dx%d -> 3x224x224, %d iterations\n", width, height, iters);
+    printf("%-24s %10.1f us/img\n", "opencv chain (fp32)", cv_us);
+    printf("%-24s %10.1f us/img  speedup %.2fx\n", "fused pipeline (fp32)", fused_us, cv_us / fused_us);
+    printf("%-24s %10.1f us/img  speedup %.2fx\n", "fused pipeline (fp16)", fp16_us, cv_us / fp16_us);
+    // 缩放结果取整方式与OpenCV的SIMD实现可能差1，对应归一化后约0.0175
+    printf("max abs diff vs opencv: %.5f\n", max_diff);
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include "session.h"
+#include "profiler.h"
+#include <yaml-cpp/yaml.h>
+#include <fstream>
+#include <random>
+
+// 端到端压测：按YAML里声明的场景驱动Session，输出吞吐、延迟分布和JSON结果
+// closed: clients个并发客户端，每个收到结果后立即发下一个
+// open:   按qps到达(constant等间隔 | poisson指数间隔)，不等结果，到达时刻由计划决定
+// 延迟有两套：latency从实际调用submit开始计；corrected按协调遗漏(coordinated omission)修正，
+// open为从计划到达时刻开始计，closed为按expected_interval_us补回被阻塞期间本应发出的请求，
+// closed没有给期望间隔时不输出corrected(用实测延迟当间隔会补进偏小的样本，反而压低尾延迟)
+// 用法: inference_bench [场景文件] [输出json]，默认 bench/inference_bench.yaml
+
+struct Scenario {
+    std::string name;
+    std::string session;             // Session的配置文件
+    std::string mode = "closed";     // closed | open
+    int clients = 1;
+    std::string arrival = "poisson"; // constant | poisson
+    double qps = 100.0;
+    double duration_s = 5.0;         // 统计窗口，不含warmup
+    double warmup_s = 1.0;
+    uint32_t expected_interval_us = 0;  // closed修正用的期望间隔，0为closed不做修正
+    uint64_t seed = 1;
+};
+
+struct ScenarioResult {
+    Scenario sc;
+    uint64_t completed{0};
+    uint64_t rejected{0};            // 准入控制拒绝
+    uint64_t dropped{0};             // 超时或失败，输出为空
+    uint64_t late{0};                // open模式下晚于计划时刻超过1ms才提交的请求
+    double window_s{0.0};
+    LatencyHistogram service;
+    LatencyHistogram corrected;
+    bool has_corrected{false};       // closed没有配置expected_interval_us时为false
+};
+
+static Scenario parseScenario(const YAML::Node& node, const std::string& default_session) {
+    Scenario sc;
+    sc.name = node["name"].as<std::string>();
+    sc.session = node["session"] ? node["session"].as<std::string>() : default_session;
+    if (node["mode"]) {
+        sc.mode = node["mode"].as<std::string>();
+    }
+    if (node["clients"]) {
+        sc.clients = std::max(1, node["clients"].as<int>());
+    }
+    if (node["arrival"]) {
+        sc.arrival = node["arrival"].as<std::string>();
+    }
+    if (node["qps"]) {
+        sc.qps = node["qps"].as<double>();
+    }
+    if (node["duration_s"]) {
+        sc.duration_s = node["duration_s"].as<double>();
+    }
+    if (node["warmup_s"]) {
+        sc.warmup_s = node["warmup_s"].as<double>();
+    }
+    if (node["expected_interval_us"]) {
+        sc.expected_interval_us = node["expected_interval_us"].as<uint32_t>();
+    }
+    if (node["seed"]) {
+        sc.seed = node["seed"].as<uint64_t>();
+    }
+    return sc;
+}
+
+// Session的配置里第一个输入的shape和dtype，内容随机，所有请求共享同一块只读内存
+static std::vector<Tensor> makeInputs(const std::string& session_yaml) {
+    auto input = YAML::LoadFile(session_yaml)["inputs"][0];
+    auto shape = input["shape"].as<std::vector<uint32_t>>();
+    auto dtype = stringToDataType(input["dtype"].as<std::string>());
+    Tensor tensor(shape, dtype);
+    std::mt19937 rng(7);
+    auto data = static_cast<uint8_t*>(tensor.data());
+    for (size_t i = 0; i < tensor.size(); i++) {
+        // 浮点类型填0，避免随机字节出现NaN
+        data[i] = dtype == FLOAT32 || dtype == FLOAT16 ? 0 : rng() & 0xff;
+    }
+    return {tensor};
+}
+
+// closed模式事后修正：一次耗时v超过期望间隔时，补记 v-interval, v-2*interval, ...
+static void recordCorrected(LatencyHistogram& hist, uint64_t ns, uint64_t interval) {
+    hist.record(ns);
+    if (interval == 0) {
+        return;
+    }
+    for (uint64_t missed = ns; missed > interval; ) {
+        missed -= interval;
+        hist.record(missed);
+    }
+}
+
+static void runClosed(Session& session, const std::vector<Tensor>& inputs, ScenarioResult& r) {
+    auto& sc = r.sc;
+    uint64_t begin = Profiler::now();
+    uint64_t measure_from = begin + (uint64_t)(sc.warmup_s * 1e9);
+    uint64_t end = measure_from + (uint64_t)(sc.duration_s * 1e9);
+    std::vector<std::vector<uint64_t>> samples(sc.clients);
+    std::vector<uint64_t> rejected(sc.clients), dropped(sc.clients);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < sc.clients; c++) {
+        clients.emplace_back([&, c]() {
+            std::mutex lock;
+            std::condition_variable cond;
+            while (true) {
+                uint64_t sent = Profiler::now();
+                if (sent >= end) {
+                    break;
+                }
+                bool done = false, empty = false;
+                bool admitted = session.submit(inputs, [&](std::vector<Tensor>&& outputs) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    done = true;
+                    empty = outputs.empty();
+                    cond.notify_one();
+                });
+                if (!admitted) {
+                    // 被拒绝后稍等再发，不要空转
+                    rejected[c] += sent >= measure_from;
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    continue;
+                }
+                std::unique_lock<std::mutex> guard(lock);
+                cond.wait(guard, [&done] { return done; });
+                if (sent < measure_from) {
+                    continue;
+                }
+                if (empty) {
+                    dropped[c]++;
+                } else {
+                    samples[c].push_back(Profiler::now() - sent);
+                }
+            }
+        });
+    }
+    for (auto& t : clients) {
+        t.join();
+    }
+    r.window_s = sc.duration_s;
+
+    std::vector<uint64_t> all;
+    for (int c = 0; c < sc.clients; c++) {
+        all.insert(all.end(), samples[c].begin(), samples[c].end());
+        r.rejected += rejected[c];
+        r.dropped += dropped[c];
+    }
+    r.completed = all.size();
+    uint64_t interval = sc.expected_interval_us * 1000ull;
+    r.has_corrected = interval > 0;
+    for (auto ns : all) {
+        r.service.record(ns);
+        if (r.has_corrected) {
+            recordCorrected(r.corrected, ns, interval);
+        }
+    }
+}
+
+static void runOpen(Session& session, const std::vector<Tensor>& inputs, ScenarioResult& r) {
+    auto& sc = r.sc;
+    r.has_corrected = true;
+    std::mt19937_64 rng(sc.seed);
+    std::exponential_distribution<double> gap(sc.qps);
+    double period = 1.0 / sc.qps;
+
+    std::atomic<uint64_t> completed{0}, dropped{0}, pending{0}, last_done{0};
+    uint64_t begin = Profiler::now();
+    uint64_t measure_from = begin + (uint64_t)(sc.warmup_s * 1e9);
+    uint64_t end = measure_from + (uint64_t)(sc.duration_s * 1e9);
+    double offset_s = 0.0;
+    while (true) {
+        offset_s += sc.arrival == "constant" ? period : gap(rng);
+        uint64_t intended = begin + (uint64_t)(offset_s * 1e9);
+        if (intended >= end) {
+            break;
+        }
+        uint64_t now = Profiler::now();
+        if (intended > now) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(intended - now));
+        }
+        // 提交方被阻塞(比如准入控制block)时后面的请求都会晚发，修正后的延迟把这段等待算进去
+        uint64_t sent = Profiler::now();
+        bool measured = intended >= measure_from;
+        r.late += measured && sent > intended + 1000000;
+        pending.fetch_add(1);
+        bool admitted = session.submit(inputs, [&, intended, sent, measured](std::vector<Tensor>&& outputs) {
+            uint64_t done = Profiler::now();
+            if (measured) {
+                if (outputs.empty()) {
+                    dropped.fetch_add(1);
+                } else {
+                    completed.fetch_add(1);
+                    uint64_t prev = last_done.load();
+                    while (prev < done && !last_done.compare_exchange_weak(prev, done)) {
+                    }
+                    r.service.record(done - sent);
+                    r.corrected.record(done - intended);
+                }
+            }
+            pending.fetch_sub(1);
+        });
+        if (!admitted) {
+            pending.fetch_sub(1);
+            r.rejected += measured;
+        }
+    }
+    session.drain();
+    while (pending.load() > 0) {
+        std::this_thread::yield();
+    }
+    // 过载时积压的请求在窗口结束后才完成，吞吐按实际完成所用的时间算
+    r.window_s = std::max(sc.duration_s, (last_done.load() - (double)measure_from) / 1e9);
+    r.completed = completed.load();
+    r.dropped = dropped.load();
+}
+
+static std::string latencyJson(const LatencyHistogram& h) {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "{\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f}",
+             h.mean() / 1e6, h.percentile(50) / 1e6, h.percentile(90) / 1e6, h.percentile(99) / 1e6,
+             h.percentile(99.9) / 1e6, h.max() / 1e6);
+    return buf;
+}
+
+static std::string toJson(const std::vector<std::unique_ptr<ScenarioResult>>& results) {
+    std::string out = "{\"scenarios\":[";
+    char buf[512];
+    for (size_t i = 0; i < results.size(); i++) {
+        auto& r = *results[i];
+        auto& sc = r.sc;
+        snprintf(buf, sizeof(buf),
+                 "%s{\"name\":\"%s\",\"session\":\"%s\",\"mode\":\"%s\",\"clients\":%d,\"arrival\":\"%s\","
+                 "\"offered_qps\":%.1f,\"duration_s\":%.2f,\"completed\":%lu,\"rejected\":%lu,\"dropped\":%lu,"
+                 "\"late\":%lu,\"throughput_qps\":%.1f,",
+                 i == 0 ? "" : ",", sc.name.c_str(), sc.session.c_str(), sc.mode.c_str(),
+                 sc.mode == "closed" ? sc.clients : 0, sc.mode == "open" ? sc.arrival.c_str() : "",
+                 sc.mode == "open" ? sc.qps : 0.0, r.window_s, r.completed, r.rejected, r.dropped, r.late,
+                 r.completed / r.window_s);
+        out += buf;
+        out += "\"latency_ms\":" + latencyJson(r.service) +
+               ",\"corrected_latency_ms\":" + (r.has_corrected ? latencyJson(r.corrected) : "null") + "}";
+    }
+    out += "]}\n";
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::string file = argc > 1 ? argv[1] : "bench/inference_bench.yaml";
+    YAML::Node config = YAML::LoadFile(file);
+    std::string default_session = config["session"] ? config["session"].as<std::string>() : "dummy_config.yaml";
+    std::string output = argc > 2 ? argv[2] : config["output"] ? config["output"].as<std::string>() : "";
+
+    Logger::getInstance()->setLevel(LOG_LEVEL_WARN);
+    std::vector<std::unique_ptr<ScenarioResult>> results;
+    printf("%-16s %-7s %-8s %-10s %-10s %-9s %-9s %-9s %-9s %-12s %-9s\n", "scenario", "mode", "load", "done",
+           "qps", "p50(ms)", "p99(ms)", "p999(ms)", "max(ms)", "cp99(ms)", "rej/drop");
+    for (auto node : config["scenarios"]) {
+        auto r = std::make_unique<ScenarioResult>();
+        r->sc = parseScenario(node, default_session);
+        auto& sc = r->sc;
+        if (sc.mode != "closed" && sc.mode != "open") {
+            ERROR_LOG("scenario %s: unknown mode %s", sc.name.c_str(), sc.mode.c_str());
+            continue;
+        }
+        // 每个场景一个新Session，统计互不影响
+        Session session(sc.session);
+        auto inputs = makeInputs(sc.session);
+        if (session.start() != SUCCESS) {
+            ERROR_LOG("scenario %s: session start fail", sc.name.c_str());
+            continue;
+        }
+        if (sc.mode == "closed") {
+            runClosed(session, inputs, *r);
+        } else {
+            runOpen(session, inputs, *r);
+        }
+        session.stop();
+
+        char load[32];
+        snprintf(load, sizeof(load), sc.mode == "closed" ? "%.0fc" : "%.0fq",
+                 sc.mode == "closed" ? (double)sc.clients : sc.qps);
+        char cp99[32] = "-";
+        if (r->has_corrected) {
+            snprintf(cp99, sizeof(cp99), "%.3f", r->corrected.percentile(99) / 1e6);
+        }
+        char drops[32];
+        snprintf(drops, sizeof(drops), "%lu/%lu", r->rejected, r->dropped);
+        printf("%-16s %-7s %-8s %-10lu %-10.1f %-9.3f %-9.3f %-9.3f %-9.3f %-12s %-9s\n", sc.name.c_str(),
+               sc.mode.c_str(), load, r->completed, r->completed / r->window_s, r->service.percentile(50) / 1e6,
+               r->service.percentile(99) / 1e6, r->service.percentile(99.9) / 1e6, r->service.max() / 1e6,
+               cp99, drops);
+        results.push_back(std::move(r));
+    }
+    if (!output.empty()) {
+        std::ofstream out(output);
+        out << toJson(results);
+        printf("results written to %s\n", output.c_str());
+    }
+    return 0;
+}
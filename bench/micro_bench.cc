@@ -0,0 +1,403 @@
+#include "executor.h"
+#include "monitor.h"
+#include "task_queue.h"
+#include "tensor.h"
+#include "util.h"
+#include "convert.h"
+#include "backend/dummy.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+// 框架热路径原语的微基准：Tensor、TaskQueue、设备内存分配、memcopy、回调、util转换和top5Indices
+// 每项自动确定迭代次数使一轮至少min_ms，跑reps轮取中位数；--json写出结果，用bench_compare和基线对比
+// 用法: micro_bench [--filter 子串] [--json 输出文件] [--min-ms 200] [--reps 5] [--list]
+// 和基线对比的结果要在同一台机器、同样的CMAKE_BUILD_TYPE(建议Release)下得到
+
+// 防止编译器把被测代码优化掉
+template <typename T>
+static inline void keep(T&& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+struct Case {
+    std::string name;
+    size_t bytes;                                // 每次操作处理的字节数，非0时额外报告带宽
+    std::function<void(uint64_t iters)> run;
+};
+
+struct CaseResult {
+    std::string name;
+    uint64_t iters;
+    double ns_per_op;                            // 各轮的中位数
+    double min_ns_per_op;                        // 各轮的最小值，受干扰最小，bench_compare默认比它
+    double gb_per_s;
+};
+
+static double timeRun(const Case& c, uint64_t iters) {
+    auto begin = std::chrono::steady_clock::now();
+    c.run(iters);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+}
+
+static CaseResult measure(const Case& c, double min_ns, int reps) {
+    // 迭代次数翻倍直到一轮超过min_ns的1/10，再按比例放大到min_ns
+    uint64_t iters = 1;
+    double ns = timeRun(c, iters);
+    while (ns < min_ns / 10 && iters < (1ull << 40)) {
+        iters *= 2;
+        ns = timeRun(c, iters);
+    }
+    iters = std::max<uint64_t>(1, (uint64_t)(iters * min_ns / std::max(ns, 1.0)));
+    std::vector<double> per_op;
+    for (int r = 0; r < reps; r++) {
+        per_op.push_back(timeRun(c, iters) / iters);
+    }
+    std::sort(per_op.begin(), per_op.end());
+    double median = per_op[per_op.size() / 2];
+    return {c.name, iters, median, per_op[0], c.bytes > 0 ? c.bytes / median : 0.0};
+}
+
+static std::string sizeName(size_t bytes) {
+    if (bytes >= (1 << 20)) {
+        return std::to_string(bytes >> 20) + "MB";
+    }
+    if (bytes >= (1 << 10)) {
+        return std::to_string(bytes >> 10) + "KB";
+    }
+    return std::to_string(bytes) + "B";
+}
+
+static void addTensorCases(std::vector<Case>& cases) {
+    for (size_t bytes : {64, 4096, 1 << 20}) {
+        std::vector<uint32_t> shape{1, (uint32_t)(bytes / 4)};
+        cases.push_back({"tensor/alloc_" + sizeName(bytes), 0, [shape](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                Tensor t(shape, FLOAT32);
+                keep(t);
+            }
+        }});
+        cases.push_back({"tensor/from_vector_" + sizeName(bytes), 0, [shape, bytes](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                Tensor t(std::vector<uint8_t>(bytes), shape, FLOAT32);
+                keep(t);
+            }
+        }});
+    }
+    cases.push_back({"tensor/copy", 0, [](uint64_t n) {
+        Tensor src({1, 1024}, FLOAT32);
+        for (uint64_t i = 0; i < n; i++) {
+            Tensor t(src);
+            keep(t);
+        }
+    }});
+    cases.push_back({"tensor/move", 0, [](uint64_t n) {
+        Tensor a({1, 1024}, FLOAT32);
+        for (uint64_t i = 0; i < n; i++) {
+            Tensor b(std::move(a));
+            keep(b);
+            a = std::move(b);
+            keep(a);
+        }
+    }});
+    cases.push_back({"tensor/view", 0, [](uint64_t n) {
+        std::vector<float> data(1024);
+        for (uint64_t i = 0; i < n; i++) {
+            auto t = Tensor::view(data.data(), {1, 1024}, FLOAT32);
+            keep(t);
+        }
+    }});
+}
+
+// producers个线程共push n个任务，consumers个线程pop并调用回调
+template <typename Queue>
+static void queueRun(uint64_t n, int producers, int consumers) {
+    Queue q;
+    std::atomic<uint64_t> done{0};
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&q]() {
+            Task task;
+            while (q.pop(task)) {
+                task.cb({});
+            }
+        });
+    }
+    std::vector<std::thread> pushers;
+    for (int p = 0; p < producers; p++) {
+        uint64_t count = n / producers + (p < (int)(n % producers) ? 1 : 0);
+        pushers.emplace_back([&q, &done, count]() {
+            for (uint64_t i = 0; i < count; i++) {
+                q.push(Task{{}, [&done](std::vector<Tensor>&&) { done.fetch_add(1, std::memory_order_relaxed); }});
+            }
+        });
+    }
+    for (auto& t : pushers) {
+        t.join();
+    }
+    while (done.load(std::memory_order_relaxed) < n) {
+        std::this_thread::yield();
+    }
+    q.shutdown();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+static void addQueueCases(std::vector<Case>& cases) {
+    cases.push_back({"queue/fifo_push_pop", 0, [](uint64_t n) {
+        FifoTaskQueue q;
+        Task task;
+        for (uint64_t i = 0; i < n; i++) {
+            q.push(Task{});
+            q.pop(task);
+        }
+    }});
+    cases.push_back({"queue/locked_push_pop", 0, [](uint64_t n) {
+        LockedTaskQueue q;
+        Task task;
+        for (uint64_t i = 0; i < n; i++) {
+            q.push(Task{});
+            q.pop(task);
+        }
+    }});
+    cases.push_back({"queue/fifo_4p4c", 0, [](uint64_t n) { queueRun<FifoTaskQueue>(n, 4, 4); }});
+    cases.push_back({"queue/locked_4p4c", 0, [](uint64_t n) { queueRun<LockedTaskQueue>(n, 4, 4); }});
+}
+
+static void addMemoryCases(std::vector<Case>& cases, Backend* backend) {
+    for (size_t bytes : {4096, 1 << 20}) {
+        cases.push_back({"alloc/backend_malloc_free_" + sizeName(bytes), 0, [backend, bytes](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                void* ptr = nullptr;
+                backend->malloc(&ptr, bytes);
+                keep(ptr);
+                backend->free(ptr);
+            }
+        }});
+        cases.push_back({"alloc/pool_acquire_release_" + sizeName(bytes), 0, [backend, bytes](uint64_t n) {
+            auto pool = backend->getMemoryPool();
+            for (uint64_t i = 0; i < n; i++) {
+                void* ptr = pool->acquire(bytes);
+                keep(ptr);
+                pool->release(ptr, bytes);
+            }
+        }});
+        cases.push_back({"alloc/pool_cache_" + sizeName(bytes), 0, [backend, bytes](uint64_t n) {
+            PoolCache cache(backend->getMemoryPool());
+            for (uint64_t i = 0; i < n; i++) {
+                void* ptr = cache.acquire(bytes);
+                keep(ptr);
+                cache.release(ptr, bytes);
+            }
+        }});
+    }
+    for (size_t bytes : {4096, 65536, 1 << 20, 16 << 20}) {
+        // 缓冲区在注册时分配并预先写过，计时里不含缺页
+        auto host = std::make_shared<std::vector<uint8_t>>(bytes, 1);
+        void* dev = nullptr;
+        backend->malloc(&dev, bytes);
+        std::memset(dev, 0, bytes);
+        cases.push_back({"memcopy/h2d_" + sizeName(bytes), bytes, [backend, bytes, host, dev](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                backend->memcopy(dev, host->data(), bytes, HOST2DEVICE);
+            }
+            keep(dev);
+        }});
+    }
+}
+
+static int __attribute__((noinline)) plainFunction(int x) {
+    return x + 1;
+}
+
+static void addCallbackCases(std::vector<Case>& cases) {
+    cases.push_back({"callback/direct_call", 0, [](uint64_t n) {
+        int (*volatile fn)(int) = plainFunction;
+        int acc = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            acc = fn(acc);
+        }
+        keep(acc);
+    }});
+    cases.push_back({"callback/std_function_call", 0, [](uint64_t n) {
+        int acc = 0;
+        std::function<void()> fn = [&acc]() { acc++; };
+        for (uint64_t i = 0; i < n; i++) {
+            // 让编译器看不到fn里存的是哪个lambda，必须间接调用
+            keep(fn);
+            fn();
+        }
+        keep(acc);
+    }});
+    // 每个任务都要构造一个TaskCallback，捕获较多时会在堆上分配
+    cases.push_back({"callback/task_cb_construct_call", 0, [](uint64_t n) {
+        uint64_t acc = 0;
+        std::vector<Tensor> outputs;
+        for (uint64_t i = 0; i < n; i++) {
+            TaskCallback cb = [&acc, i](std::vector<Tensor>&& out) { acc += i + out.size(); };
+            keep(cb);
+            cb(std::move(outputs));
+        }
+        keep(acc);
+    }});
+    cases.push_back({"callback/task_cb_large_capture", 0, [](uint64_t n) {
+        uint64_t acc = 0;
+        std::vector<Tensor> outputs;
+        auto shared = std::make_shared<int>(1);
+        for (uint64_t i = 0; i < n; i++) {
+            TaskCallback cb = [&acc, i, shared, outputs](std::vector<Tensor>&& out) { acc += i + *shared; };
+            keep(cb);
+            cb(std::move(outputs));
+        }
+        keep(acc);
+    }});
+}
+
+static void addUtilCases(std::vector<Case>& cases) {
+    const size_t count = 16384;
+    std::vector<uint8_t> bytes(count * 4);
+    std::mt19937 rng(3);
+    std::vector<float> floats(count);
+    for (auto& f : floats) {
+        f = std::uniform_real_distribution<float>(-4.0f, 4.0f)(rng);
+    }
+    std::memcpy(bytes.data(), floats.data(), bytes.size());
+    auto half = std::make_shared<std::vector<uint16_t>>(count);
+    floatToHalf(floats.data(), half->data(), count);
+
+    cases.push_back({"util/bytesToFloat32_64KB", count * 4, [bytes](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            auto v = bytesToFloat32(bytes);
+            keep(v);
+        }
+    }});
+    cases.push_back({"util/bytesToUint16_64KB", count * 4, [bytes](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            auto v = bytesToUint16(bytes);
+            keep(v);
+        }
+    }});
+    cases.push_back({"util/tensorToFloat32_fp16_16K", count * 2, [half](uint64_t n) {
+        auto t = Tensor::view(half->data(), {1, (uint32_t)half->size()}, FLOAT16);
+        for (uint64_t i = 0; i < n; i++) {
+            auto v = tensorToFloat32(t);
+            keep(v);
+        }
+    }});
+    cases.push_back({"util/tensorToFloat32_int8_16K", count, [count](uint64_t n) {
+        auto t = Tensor({1, (uint32_t)count}, INT8);
+        std::memset(t.data(), 3, t.size());
+        for (uint64_t i = 0; i < n; i++) {
+            auto v = tensorToFloat32(t, {0.02f, 0});
+            keep(v);
+        }
+    }});
+    cases.push_back({"util/floatToHalf_16K", count * 4, [floats](uint64_t n) {
+        std::vector<uint16_t> out(floats.size());
+        for (uint64_t i = 0; i < n; i++) {
+            floatToHalf(floats.data(), out.data(), floats.size());
+            keep(out);
+        }
+    }});
+    cases.push_back({"util/quantizeInt8_16K", count * 4, [floats](uint64_t n) {
+        std::vector<int8_t> out(floats.size());
+        for (uint64_t i = 0; i < n; i++) {
+            quantizeInt8(floats.data(), out.data(), floats.size(), {0.05f, 0});
+            keep(out);
+        }
+    }});
+    for (size_t classes : {1000, 21843}) {
+        std::vector<float> scores(classes);
+        for (auto& s : scores) {
+            s = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+        }
+        cases.push_back({"util/top5Indices_" + std::to_string(classes), 0, [scores](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                auto top = top5Indices(scores);
+                keep(top);
+            }
+        }});
+    }
+}
+
+static std::string toJson(const std::vector<CaseResult>& results, double min_ms, int reps) {
+    std::string out = "{\"min_ms\":" + std::to_string(min_ms) + ",\"reps\":" + std::to_string(reps) +
+                      ",\"simd\":\"" + convertSimdName() + "\",\"results\":[";
+    char buf[256];
+    for (size_t i = 0; i < results.size(); i++) {
+        auto& r = results[i];
+        snprintf(buf, sizeof(buf),
+                 "%s\n  {\"name\":\"%s\",\"iters\":%lu,\"ns_per_op\":%.3f,\"min_ns_per_op\":%.3f,\"gb_per_s\":%.3f}",
+                 i == 0 ? "" : ",", r.name.c_str(), r.iters, r.ns_per_op, r.min_ns_per_op, r.gb_per_s);
+        out += buf;
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::string filter, json;
+    double min_ms = 200;
+    int reps = 5;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            json = argv[++i];
+        } else if (arg == "--min-ms" && i + 1 < argc) {
+            min_ms = std::atof(argv[++i]);
+        } else if (arg == "--reps" && i + 1 < argc) {
+            reps = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--list") {
+            list = true;
+        } else {
+            fprintf(stderr, "usage: %s [--filter substr] [--json out.json] [--min-ms 200] [--reps 5] [--list]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    Logger::getInstance()->setLevel(LOG_LEVEL_ERROR);
+    auto backend = Monitor::getInstance()->getBackend(BACKEND_DUMMY, 0);
+    if (backend == nullptr) {
+        ERROR_LOG("no dummy backend");
+        return 1;
+    }
+    std::vector<Case> cases;
+    addTensorCases(cases);
+    addQueueCases(cases);
+    addMemoryCases(cases, backend);
+    addCallbackCases(cases);
+    addUtilCases(cases);
+
+    std::vector<CaseResult> results;
+    printf("%-36s %14s %12s %10s\n", "benchmark", "iters", "ns/op", "GB/s");
+    for (auto& c : cases) {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        if (list) {
+            printf("%s\n", c.name.c_str());
+            continue;
+        }
+        auto r = measure(c, min_ms * 1e6, reps);
+        if (r.gb_per_s > 0) {
+            printf("%-36s %14lu %12.2f %10.2f\n", r.name.c_str(), r.iters, r.ns_per_op, r.gb_per_s);
+        } else {
+            printf("%-36s %14lu %12.2f %10s\n", r.name.c_str(), r.iters, r.ns_per_op, "-");
+        }
+        fflush(stdout);
+        results.push_back(r);
+    }
+    if (!json.empty()) {
+        std::ofstream out(json);
+        out << toJson(results, min_ms, reps);
+        printf("results written to %s\n", json.c_str());
+    }
+    return 0;
+}
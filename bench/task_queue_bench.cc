@@ -0,0 +1,67 @@
+#include "task_queue.h"
+#include "deadline_queue.h"
+#include "tensor.h"
+#include <chrono>
+
+// FifoTaskQueue(无锁)、LockedTaskQueue(互斥锁+条件变量) 与 DeadlineQueue(EDF) 的吞吐对比
+// 用法: task_queue_bench [任务总数] [生产者线程数]
+
+template <typename Queue>
+double runOnce(int num_consumer, int num_producer, int num_task) {
+    Queue q;
+    std::atomic<int> done{0};
+    std::vector<std::thread> consumers;
+    consumers.reserve(num_consumer);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_consumer; i++) {
+        consumers.emplace_back([&q]() {
+            Task task;
+            while (q.pop(task)) {
+                task.cb({});
+            }
+        });
+    }
+
+    std::vector<std::thread> producers;
+    producers.reserve(num_producer);
+    for (int p = 0; p < num_producer; p++) {
+        int count = num_task / num_producer + (p < num_task % num_producer ? 1 : 0);
+        producers.emplace_back([&q, &done, count]() {
+            for (int i = 0; i < count; i++) {
+                q.push(Task{{}, [&done](std::vector<Tensor>&&) {
+                    done.fetch_add(1, std::memory_order_relaxed);
+                }});
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    while (done.load(std::memory_order_relaxed) < num_task) {
+        std::this_thread::yield();
+    }
+    q.shutdown();
+    for (auto& t : consumers) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    return num_task / sec / 1e6;
+}
+
+int main(int argc, char** argv) {
+    int num_task = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int num_producer = argc > 2 ? std::atoi(argv[2]) : 1;
+
+    printf("tasks = %d, producers = %d\n", num_task, num_producer);
+    printf("%-10s %-18s %-18s %-8s %-18s\n", "executors", "locked(Mops/s)", "lockfree(Mops/s)", "speedup",
+           "edf(Mops/s)");
+    for (int n = 1; n <= 64; n *= 2) {
+        double locked = runOnce<LockedTaskQueue>(n, num_producer, num_task);
+        double lockfree = runOnce<FifoTaskQueue>(n, num_producer, num_task);
+        double edf = runOnce<DeadlineQueue>(n, num_producer, num_task);
+        printf("%-10d %-18.3f %-18.3f %-8.2f %-18.3f\n", n, locked, lockfree, lockfree / locked, edf);
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "executor.h"
+#include "monitor.h"
+#include "work_stealing_queue.h"
+#include "backend/dummy.h"
+#include <chrono>
+
+// 单个共享FifoTaskQueue 与 每个executor一个本地队列的WorkStealingQueue 在Dummy后端上的扩展性对比
+// 推理耗时为0，吞吐只受取任务和executor自身开销限制
+// 用法: work_stealing_bench [任务总数] [生产者线程数] [推理耗时us]
+
+struct RunResult {
+    double ktps;        // 千任务/秒
+    uint64_t steals;
+};
+
+static RunResult runOnce(TaskQueue& q, Backend* backend, int num_executor, int num_producer, int num_task) {
+    std::vector<std::unique_ptr<Executor>> executors;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_executor; i++) {
+        executors.push_back(std::make_unique<Executor>("dummy", backend, &q, i, FLOAT32));
+    }
+    std::atomic<int> done{0};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_executor; i++) {
+        threads.emplace_back([&executors, i] { executors[i]->Execute(); });
+    }
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producer; p++) {
+        int count = num_task / num_producer + (p < num_task % num_producer ? 1 : 0);
+        producers.emplace_back([&q, &done, count]() {
+            std::vector<uint8_t> bytes(5 * sizeof(float));
+            for (int i = 0; i < count; i++) {
+                q.push(Task{{Tensor(bytes, {1, 5}, FLOAT32)}, [&done](std::vector<Tensor>&&) {
+                    done.fetch_add(1, std::memory_order_relaxed);
+                }});
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    while (done.load(std::memory_order_relaxed) < num_task) {
+        std::this_thread::yield();
+    }
+    auto end = std::chrono::steady_clock::now();
+    q.shutdown();
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto ws = dynamic_cast<WorkStealingQueue*>(&q);
+    double sec = std::chrono::duration<double>(end - start).count();
+    return {num_task / sec / 1e3, ws ? ws->stealCount() : 0};
+}
+
+int main(int argc, char** argv) {
+    int num_task = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int num_producer = argc > 2 ? std::atoi(argv[2]) : 4;
+    uint32_t infer_us = argc > 3 ? std::atoi(argv[3]) : 0;
+
+    Logger::getInstance()->setLevel(LOG_LEVEL_ERROR);
+    auto backend = static_cast<Dummy*>(Monitor::getInstance()->getBackend(BACKEND_DUMMY, 0));
+    if (backend == nullptr) {
+        ERROR_LOG("no dummy backend");
+        return 1;
+    }
+    backend->setLatency({infer_us, 0.0});
+
+    printf("tasks = %d, producers = %d, infer = %u us\n", num_task, num_producer, infer_us);
+    printf("%-10s %-16s %-16s %-8s %-10s\n", "executors", "shared(Ktask/s)", "steal(Ktask/s)", "speedup", "steals");
+    for (int n = 1; n <= 64; n *= 2) {
+        FifoTaskQueue shared;
+        WorkStealingQueue local(n);
+        auto a = runOnce(shared, backend, n, num_producer, num_task);
+        auto b = runOnce(local, backend, n, num_producer, num_task);
+        printf("%-10d %-16.1f %-16.1f %-8.2f %-10lu\n", n, a.ktps, b.ktps, b.ktps / a.ktps, b.steals);
+    }
+    return 0;
+}
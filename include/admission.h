@@ -0,0 +1,52 @@
+#pragma once
+
+#include "common.h"
+
+enum OverflowPolicy {
+    OVERFLOW_BLOCK,     // 阻塞提交方直到有名额
+    OVERFLOW_TIMEOUT,   // 最多阻塞timeout_ms，超时后拒绝
+    OVERFLOW_REJECT,    // 立即拒绝
+};
+
+OverflowPolicy stringToOverflowPolicy(const std::string& str);
+
+struct AdmissionCfg {
+    size_t max_inflight = 0;         // 已提交但回调还没返回的请求上限(含排队中的)，0不限
+    size_t max_queued = 0;           // TaskQueue中等待executor的请求上限，0不限
+    OverflowPolicy overflow = OVERFLOW_BLOCK;
+    uint32_t timeout_ms = 100;       // 只对timeout生效
+};
+
+// -----------------------------
+// Session的准入控制：请求数达到上限时按overflow阻塞、限时等待或直接拒绝提交方，
+// 排队和在途的输入张量因此有上界，host内存不随提交速度增长
+// 名额在submit时占用，任务完成(回调返回或被丢弃)后release归还
+// -----------------------------
+class AdmissionControl {
+  public:
+    // queued返回当前排队的请求数，只在配置了max_queued时调用
+    AdmissionControl(const AdmissionCfg& cfg, std::function<size_t()> queued);
+
+    // 返回false表示被拒绝(OVERFLOW_REJECT)或等待超时，此时不占用名额；
+    // must_wait为true时忽略overflow一直等，用于不能丢弃的内部提交
+    bool acquire(bool must_wait = false);
+    void release();
+
+    size_t inflight() const;
+    void logStats() const;
+
+  private:
+    bool hasRoom() const;
+
+    AdmissionCfg cfg_;
+    std::function<size_t()> queued_;
+
+    mutable std::mutex lock_;
+    std::condition_variable cond_;
+    size_t inflight_{0};
+    size_t peak_inflight_{0};
+    uint64_t admitted_{0};
+    uint64_t waited_{0};             // 需要等待才拿到名额的次数
+    uint64_t rejected_{0};
+    uint64_t timed_out_{0};
+};
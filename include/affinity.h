@@ -0,0 +1,71 @@
+#pragma once
+
+#include "common.h"
+
+struct AffinityCfg {
+    std::string executors;           // 核心列表如"0-7,16-23"；"numa"为绑到所在设备的NUMA节点；空为不绑定
+    std::string preprocess;          // 预处理线程的核心列表，同上但没有设备，"numa"时轮流分到各节点
+    bool per_core = true;            // 每个线程独占列表中的一个核(轮流分配)，否则绑定到整个列表
+    bool numa_memory = true;         // 线程的host内存优先从其核所在的NUMA节点分配
+};
+
+// -----------------------------
+// CpuTopology 定义
+// 从/sys读取NUMA节点和核的对应关系，只保留进程允许使用的核；读不到时当作单节点
+// -----------------------------
+class CpuTopology {
+  public:
+    static const CpuTopology& get();
+
+    int numNodes() const { return (int)node_cpus_.size(); }
+    // 不在允许集合里的核返回-1
+    int nodeOf(int cpu) const;
+    const std::vector<int>& cpusOf(int node) const { return node_cpus_[node]; }
+    const std::vector<int>& allCpus() const { return all_cpus_; }
+
+    // 解析"0-3,8,10-11"，格式错误时返回空
+    static std::vector<int> parseCpuList(const std::string& str);
+    static std::string formatCpuList(const std::vector<int>& cpus);
+
+  private:
+    CpuTopology();
+
+    std::vector<std::vector<int>> node_cpus_;
+    std::vector<int> all_cpus_;
+    std::unordered_map<int, int> cpu_node_;
+};
+
+// 一个线程的放置结果，cpus为空表示不绑定
+struct ThreadPlacement {
+    std::string name;
+    std::vector<int> cpus;
+    int node = -1;                   // 内存绑定的NUMA节点，-1为不绑定
+};
+
+// -----------------------------
+// ThreadPlacer 定义
+// 按AffinityCfg给一组同类线程(executor或预处理worker)分配核，线程启动后在自己身上调用apply
+// plan在启动线程前算好，便于一次性打印
+// -----------------------------
+class ThreadPlacer {
+  public:
+    // cpus为空时plan只设置线程名
+    ThreadPlacer(const std::string& prefix, const std::string& cpus, const AffinityCfg& cfg);
+
+    // 第index个线程的放置；node>=0时只在该节点的核里选(cpus为"numa"时)
+    ThreadPlacement plan(int index, int node = -1);
+
+    // 绑定调用线程并设置线程名，失败只打印警告
+    static void apply(const ThreadPlacement& placement);
+    static void logPlan(const std::vector<ThreadPlacement>& plans);
+
+  private:
+    std::string prefix_;
+    bool by_node_{false};
+    std::vector<int> cpus_;
+    AffinityCfg cfg_;
+    std::unordered_map<int, int> next_in_node_;  // by_node_时每个节点已经分出去的核数
+};
+
+// 设置调用线程的名字，超过15个字符的部分被截掉
+void setThreadName(const std::string& name);
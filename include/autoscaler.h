@@ -0,0 +1,70 @@
+#pragma once
+
+#include "common.h"
+#include "profiler.h"
+
+struct AutoscaleCfg {
+    int min_executors = 1;
+    int max_executors = 8;
+    uint32_t interval_ms = 200;      // 采样和决策周期，也是延迟统计的窗口
+    double queue_per_executor = 4.0; // 排队任务数超过 该值*executor数 时扩容
+    uint32_t p99_ms = 0;             // 窗口内p99超过该值时扩容，0为不看延迟
+    double low_utilization = 0.5;    // 窗口内executor的忙碌时间占比(各executor busy时间之和/窗口/executor数)低于该值且队列为空
+    uint32_t idle_ms = 2000;         // 持续该时间后缩容一个
+    uint32_t cooldown_ms = 500;      // 两次调整之间的最小间隔
+    double min_gain = 0.05;          // 扩容后吞吐提升低于该比例时认为到了设备并发上限，退回并不再扩容
+};
+
+// -----------------------------
+// Autoscaler 定义
+// 周期性地看TaskQueue深度和窗口内的端到端延迟，在[min, max]之间增减executor
+// 扩容：排队过长或p99超标；缩容：队列为空且executor忙碌时间占比持续偏低
+// 扩容没有带来吞吐提升时说明设备已经饱和(拐点)，退回一个并在下次缩容前不再扩容
+// 具体怎么增删executor由Session通过回调实现，这里只做决策
+// -----------------------------
+class Autoscaler {
+  public:
+    struct Hooks {
+        std::function<size_t()> queue_depth;
+        std::function<int()> live;       // 当前在服务(没有被要求退出)的executor数
+        std::function<bool()> scale_up;  // 返回false表示没加成功
+        std::function<bool()> scale_down;
+        std::function<uint64_t()> busy_ns;  // 所有executor(含已退出的)累计的忙碌时间，单调不减
+    };
+
+    Autoscaler(const AutoscaleCfg& cfg, Hooks hooks);
+    ~Autoscaler();
+
+    void start();
+    void stop();
+    // 任务完成时调用，latency为入队到回调的耗时
+    void record(uint64_t latency_ns);
+
+    uint64_t scaleUps() const { return ups_; }
+    uint64_t scaleDowns() const { return downs_; }
+
+  private:
+    void loop();
+    void tick(uint64_t now);
+
+    AutoscaleCfg cfg_;
+    Hooks hooks_;
+    // 双缓冲：record写当前窗口，tick切换后等还在写上一个窗口的record结束，再读取并清零
+    LatencyHistogram windows_[2];
+    std::atomic<int> writers_[2] = {{0}, {0}};
+    std::atomic<int> current_{0};
+    uint64_t window_begin_{0};
+    uint64_t last_busy_ns_{0};
+    uint64_t last_change_{0};
+    uint64_t idle_since_{0};         // 0表示当前不空闲
+    int last_up_live_{0};            // 上次扩容前的executor数和吞吐，0表示没有
+    double last_up_tput_{0.0};
+    int knee_{0};                    // 探测到的executor数上限，0表示未知
+    uint64_t ups_{0};
+    uint64_t downs_{0};
+
+    std::mutex lock_;
+    std::condition_variable cond_;
+    bool stop_{true};
+    std::thread worker_;
+};
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "common.h"
+#include "memory_pool.h"
+#include "model_info.h"
+#include "model_registry.h"
 
-class ModelInfo;
 class Stream;
 class Model;
 class Event;
@@ -11,47 +13,94 @@ class Backend {
   public:
     Backend(BackendType type, int device_id) 
     : type_(type),
-      device_id_(device_id) {}    
+      device_id_(device_id),
+      registry_([this](const std::string& path) { return loadModel(path); },
+                [this](Model* model) { unloadModel(model); }),
+      pool_(std::make_unique<MemoryPool>(this)),
+      host_pool_(std::make_unique<MemoryPool>(this, true)) {}
     virtual ~Backend() = default;
 
     virtual Result init() = 0;
     virtual Result finalize() = 0;
+    // 把设备上下文绑定到调用线程，同一进程用多张卡时每个executor线程开始前调用
+    virtual Result bindThread() { return SUCCESS; }
     virtual Result malloc(void **dev_ptr, size_t size) = 0;
     virtual Result free(void *dev_ptr) = 0;
+    // 主机侧内存，后端支持锁页内存时覆盖，拷贝更快
+    virtual Result mallocHost(void **host_ptr, size_t size) {
+        *host_ptr = std::malloc(size);
+        return *host_ptr == nullptr ? FAIL : SUCCESS;
+    }
+    virtual Result freeHost(void *host_ptr) {
+        std::free(host_ptr);
+        return SUCCESS;
+    }
     virtual Result memcopy(void *dst, const void *src, uint64_t size, DIRECTION dir) = 0;
-    virtual uint32_t loadModel(const std::string &path) = 0;
-    virtual Result unloadModel(const std::string& path) = 0;
-    virtual Result infer(Stream* stream, uint32_t model_id, void* dev_input_ptr, void* dev_output_ptr) = 0;
-    virtual const ModelInfo* getModelInfo(uint32_t model_id) const = 0;
+    // 异步拷贝，只负责把拷贝放入stream，完成时机由event或stream同步保证
+    virtual Result memcopyAsync(Stream* stream, void *dst, const void *src, uint64_t size, DIRECTION dir) = 0;
+    // 同一路径只加载一次，句柄全部释放后卸载，加载失败返回空
+    ModelHandle acquireModel(const std::string& path) { return registry_.acquire(path); }
+    // model由调用方持有的句柄保证有效，推理时不再查表
+    virtual Result infer(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) = 0;
+    virtual Result inferAsync(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) = 0;
+    // 按id查找已加载模型的信息，不加锁
+    const ModelInfo* getModelInfo(uint32_t model_id) const;
 
     virtual std::unique_ptr<Stream> createStream() = 0;
     virtual Result destoryStream(Stream* stream) = 0;
+    virtual std::unique_ptr<Event> createEvent() = 0;
+    virtual Result destoryEvent(Event* event) = 0;
 
     BackendType getBackendType() { return type_; }
+    int getDeviceId() const { return device_id_; }
+    // 设备内存池，executor通过它复用设备内存，避免每个任务都malloc/free
+    MemoryPool* getMemoryPool() { return pool_.get(); }
+    // 主机内存池，输出张量直接用它的内存，交给调用方后不再拷贝
+    MemoryPool* getHostMemoryPool() { return host_pool_.get(); }
 
   protected:
+    // 由ModelRegistry调用，同一路径同时只会有一次加载或卸载；子类加载时填好Model的info
+    virtual std::unique_ptr<Model> loadModel(const std::string& path) = 0;
+    virtual Result unloadModel(Model* model) = 0;
+
     int device_id_;
-    uint32_t next_model_id_{0};
     BackendType type_;
 
-    mutable std::mutex model_lock_;
+    ModelRegistry registry_;
 
-    std::unordered_map<std::string, uint32_t> path_to_id_;
-    std::unordered_map<uint32_t, std::unique_ptr<Model>> models_;
-    std::unordered_map<uint32_t, std::unique_ptr<ModelInfo>> infos_;
+    // 子类需要在析构或finalize时调用pool_->trim()，基类析构中无法调用虚函数free
+    std::unique_ptr<MemoryPool> pool_;
+    std::unique_ptr<MemoryPool> host_pool_;
 };
 
 class Model {
   public:
-    Model(Backend* backend) : backend_(backend) {}
+    Model(Backend* backend, std::unique_ptr<ModelInfo> info = nullptr)
+        : backend_(backend), info_(std::move(info)) {}
     virtual ~Model() {}
-    virtual void* getHandle() { return nullptr; }
+    virtual void* getHandle() const { return nullptr; }
     Backend* getBackend() { return backend_; }
+    const ModelInfo* getInfo() const { return info_.get(); }
+    // id和路径由ModelRegistry在加载成功后设置
+    uint32_t getId() const { return id_; }
+    const std::string& getPath() const { return path_; }
+    // 模型本身占用的设备内存，后端不知道时为0
+    uint64_t getDeviceBytes() const { return device_bytes_; }
 
   protected:
+    friend class ModelRegistry;
     Backend* backend_;
+    std::unique_ptr<ModelInfo> info_;
+    uint64_t device_bytes_{0};
+    uint32_t id_{0};
+    std::string path_;
 };
 
+inline const ModelInfo* Backend::getModelInfo(uint32_t model_id) const {
+    auto model = registry_.find(model_id);
+    return model == nullptr ? nullptr : model->getInfo();
+}
+
 class Stream {
   public:
     Stream() = default;
@@ -62,6 +111,12 @@ class Stream {
     virtual Result destoryStream() { return SUCCESS; }
     virtual Result recordEvent(Event* event) { return SUCCESS; }
     virtual Result waitEvent(Event* event) { return SUCCESS; }
+    // 在stream中插入主机回调，之前放入stream的操作都完成后才会执行
+    virtual Result addCallback(std::function<void()> cb) {
+        auto res = synchronize();
+        cb();
+        return res;
+    }
     virtual void* getStream() { return nullptr; }
     Backend* getBackend() { return backend_; }
     
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "backend.h"
+#include "common.h"
+#include "model_info.h"
+#include "thread_pool.h"
+#include "backend/cpu_kernels.h"
+
+// -----------------------------
+// Cpu 后端
+// 在主机上真正执行小模型(LeNet这一级别的conv/pool/fc/relu/softmax)，用于没有Lynxi卡时压测整个框架，
+// 或者加速卡满载时作为兜底设备。模型是一个描述网络结构的yaml文件，见models/lenet_cpu.yaml
+// "设备内存"就是64字节对齐的主机内存，stream和event复用Dummy的主机线程实现
+// -----------------------------
+class Cpu : public Backend {
+  public:
+    Cpu(int device_id = 0);
+    virtual ~Cpu();
+
+    Result init() override;
+    Result finalize() override;
+    Result malloc(void **dev_ptr, uint64_t size) override;
+    Result free(void *dev_prt) override;
+    Result memcopy(void *dst, const void *src, uint64_t size, DIRECTION dir) override;
+    Result memcopyAsync(Stream* stream, void *dst, const void *src, uint64_t size, DIRECTION dir) override;
+    Result infer(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) override;
+    Result inferAsync(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) override;
+    std::unique_ptr<Stream> createStream() override;
+    Result destoryStream(Stream* stream) override;
+    std::unique_ptr<Event> createEvent() override;
+    Result destoryEvent(Event* event) override;
+
+    // 算子并行使用的线程数(含调用线程)，需要在init之前设置
+    void setNumThreads(size_t num_threads) { num_threads_ = std::max<size_t>(num_threads, 1); }
+
+  protected:
+    std::unique_ptr<Model> loadModel(const std::string &path) override;
+    Result unloadModel(Model* model) override;
+
+  private:
+    size_t num_threads_;
+    std::unique_ptr<ThreadPool> thread_pool_;
+};
+
+enum CpuLayerType {
+    CPU_CONV,
+    CPU_MAXPOOL,
+    CPU_AVGPOOL,
+    CPU_FC,
+    CPU_RELU,
+    CPU_SOFTMAX,
+    CPU_FLATTEN,
+};
+
+struct CpuLayer {
+    CpuLayerType type;
+    cpu::ConvParam conv{};
+    cpu::PoolParam pool{};
+    int in_features{0};
+    int out_features{0};
+    size_t weight_offset{0};
+    size_t bias_offset{0};
+    size_t out_size{0};  // 单个样本的输出元素数
+};
+
+class CpuModel : public Model {
+  public:
+    CpuModel(Backend* backend) : Model(backend) {}
+    virtual ~CpuModel() {}
+
+    Result load(const std::string& path);
+    // input和output各包含batch个连续的样本
+    void run(const void* input, void* output, size_t batch, ThreadPool* pool) const;
+
+  private:
+    std::unique_ptr<ModelInfo> makeInfo() const;
+    Result loadWeights(const std::string& path, size_t count);
+    void randomWeights(size_t count, uint32_t seed);
+
+    std::vector<CpuLayer> layers_;
+    std::vector<float> weights_;
+    size_t batch_{1};
+    int in_c_{1}, in_h_{1}, in_w_{1};
+    DataType input_dtype_{FLOAT32};
+    float input_scale_{1.0f};   // uint8输入先乘这个系数
+    size_t max_size_{0};        // 各层输出的最大元素数，决定中间缓冲大小
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common.h"
+#include "thread_pool.h"
+
+// -----------------------------
+// CPU后端的算子，全部为float32、NCHW、单个样本
+// 内层循环用AVX2/FMA(x86，运行时检测)或NEON(aarch64)向量化，外层按输出通道在ThreadPool上并行
+// -----------------------------
+namespace cpu {
+
+// 当前使用的指令集，"avx2" / "neon" / "scalar"
+const char* simdName();
+
+// y += a * x
+void axpy(float a, const float* x, float* y, size_t n);
+float dot(const float* a, const float* b, size_t n);
+
+struct ConvParam {
+    int in_c, in_h, in_w;
+    int out_c, out_h, out_w;
+    int kernel, stride, pad;
+};
+
+// weight为[out_c, in_c, kernel, kernel]，bias为[out_c]
+void conv2d(const ConvParam& p, const float* input, const float* weight, const float* bias,
+            float* output, ThreadPool* pool);
+
+struct PoolParam {
+    int channels, in_h, in_w;
+    int out_h, out_w;
+    int kernel, stride;
+};
+
+void maxPool2d(const PoolParam& p, const float* input, float* output, ThreadPool* pool);
+void avgPool2d(const PoolParam& p, const float* input, float* output, ThreadPool* pool);
+
+// weight为[out_features, in_features]
+void fullyConnected(int in_features, int out_features, const float* input, const float* weight,
+                    const float* bias, float* output, ThreadPool* pool);
+
+void relu(float* data, size_t n);
+void softmax(float* data, size_t n);
+
+}  // namespace cpu
@@ -5,36 +5,205 @@
 #include "common.h"
 #include "executor.h"
 #include "model_info.h"
+#include <chrono>
+#include <deque>
 
+// 模拟设备耗时，全为0时不做任何等待
+struct DummyLatency {
+    uint32_t infer_us{0};   // 每次推理的耗时，模型profile里写了耗时的以profile为准
+    double copy_gbps{0.0};  // 拷贝带宽，GB/s
+    uint32_t max_concurrency{0};  // 设备上同时执行的推理数上限，超出的排队等待，0不限
+    uint64_t memory_bytes{8ull << 30};  // 设备内存容量，malloc和加载模型超出时失败
+};
+
+// 模拟模型占用的设备内存和加载耗时，全为0时加载立即完成且不占内存
+struct DummyModelCost {
+    uint64_t size_bytes{0};
+    uint32_t load_ms{0};
+};
+
+// 推理耗时的随机抖动，加在 fixed_us + per_sample_us * batch 上
+struct DummyJitter {
+    std::string dist = "none";  // none | uniform | normal | exponential | lognormal
+    double us{0.0};             // uniform为[0, us)，normal为标准差，exponential为均值
+    double sigma{0.0};          // lognormal: 耗时乘以exp(N(0, sigma))
+};
+
+// -----------------------------
+// DummyModelProfile 定义
+// dummy的模型路径指向一个YAML时从中读取模型的输入输出、batch和耗时模型，
+// 否则为{1,5} float32、耗时取DummyLatency.infer_us的默认模型
+// 文件里的device段是设备属性(拷贝带宽、并发数、内存容量)，Session用它覆盖dummy_latency
+// -----------------------------
+struct DummyModelProfile {
+    size_t batch{1};
+    // shape是单个样本的，和Session配置的inputs/outputs一致
+    std::vector<std::vector<uint32_t>> inputs_shape{{1, 5}};
+    std::vector<DataType> inputs_dtype{FLOAT32};
+    std::vector<std::vector<uint32_t>> outputs_shape{{1, 5}};
+    std::vector<DataType> outputs_dtype{FLOAT32};
+    bool has_latency{false};    // false时用设备的DummyLatency.infer_us
+    double fixed_us{0.0};
+    double per_sample_us{0.0};
+    DummyJitter jitter;
+    DummyModelCost cost;
+    DummyLatency device;        // 只覆盖文件里写了的项
+
+    // 路径以.yaml/.yml结尾时按profile读取
+    static bool isProfile(const std::string& path);
+    // 路径不是YAML文件、读不了或字段不合法时返回FAIL，profile保持原值
+    static Result load(const std::string& path, DummyModelProfile& profile);
+    // 一次推理的耗时(us)，含抖动，不含speed和降频
+    double sampleLatencyUs(size_t batch) const;
+};
+
+// 脚本化的设备遥测，相邻两点之间线性插值，最后一点之后保持不变
+struct DummyTelemetryPoint {
+    uint32_t at_ms{0};       // 距setTelemetryScript的时间
+    int32_t temperature{0};
+    double memory_rate{-1.0};  // 显存占用比例，<0表示不覆盖真实统计
+};
+
+// 可以创建多个Dummy模拟多张卡，speed不同的卡推理和拷贝耗时按比例缩放
 class Dummy : public Backend {
   public:
-    Dummy() : Backend(BACKEND_DUMMY, 114514) {}
-    virtual ~Dummy() {}
+    Dummy(int device_id = 0) : Backend(BACKEND_DUMMY, device_id), last_sample_(Clock::now()) {}
+    virtual ~Dummy() {
+      pool_->trim();
+      host_pool_->trim();
+    }
 
     Result init() override;
     Result finalize() override;
     Result malloc(void **dev_ptr, uint64_t size) override;
     Result free(void *dev_prt) override;
     Result memcopy(void *dst, const void *src, uint64_t size, DIRECTION dir) override;
-    uint32_t loadModel(const std::string &path) override;
-    Result unloadModel(const std::string& path) override;
-    Result infer(Stream* stream, uint32_t model_id, void* dev_input_ptr, void* dev_output_ptr) override;
+    Result memcopyAsync(Stream* stream, void *dst, const void *src, uint64_t size, DIRECTION dir) override;
+    Result infer(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) override;
+    Result inferAsync(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) override;
     std::unique_ptr<Stream> createStream() override;
-    const ModelInfo* getModelInfo(uint32_t model_id) const override;
     Result destoryStream(Stream* stream) override;
+    std::unique_ptr<Event> createEvent() override;
+    Result destoryEvent(Event* event) override;
+
+    void setLatency(const DummyLatency& latency) { latency_ = latency; }
+    // 需要在loadModel之前设置
+    void setBatchSize(size_t batch) { batch_size_ = batch; }
+    // 相对速度，2.0表示比基准快一倍
+    void setSpeed(double speed) { speed_ = speed > 0.0 ? speed : 1.0; }
+    // path为空时作为所有没有单独设置的模型的默认值
+    void setModelCost(const std::string& path, const DummyModelCost& cost);
+
+    // 模拟设备属性，供Monitor采样
+    // 距上次调用期间推理占用的时间比例，0~100
+    uint32_t usageRate();
+    uint64_t memoryUsed() const;
+    uint64_t memoryTotal() const { return latency_.memory_bytes; }
+    // 按最近的使用率模拟芯片温度，每次usageRate时更新；设置了脚本时按脚本
+    int32_t temperature() const;
+    int32_t temperatureLimit() const { return kTemperatureLimit; }
+    // 用于测试限流，脚本为空时恢复模拟值；温度距上限不到kThrottleMargin时和真卡一样降频，推理耗时翻倍
+    void setTelemetryScript(std::vector<DummyTelemetryPoint> script);
+
+  protected:
+    std::unique_ptr<Model> loadModel(const std::string &path) override;
+    Result unloadModel(Model* model) override;
 
   private:
-    std::unique_ptr<ModelInfo> info_{nullptr};
+    using Clock = std::chrono::steady_clock;
+    static constexpr int32_t kTemperatureIdle = 40;
+    static constexpr int32_t kTemperatureLimit = 95;
+    static constexpr int32_t kThrottleMargin = 5;
+    static constexpr double kThermalTauSec = 2.0;  // 温度变化的时间常数
+
+    void copyDelay(uint64_t size) const;
+    // 当前时刻的脚本值，没有脚本时返回false
+    bool scripted(DummyTelemetryPoint& point) const;
+    void runModel(const DummyModelProfile& profile, void* dev_input_ptr, void* dev_output_ptr) const;
+
+    DummyLatency latency_;
+    size_t batch_size_{1};
+    double speed_{1.0};
+
+    std::mutex cost_lock_;
+    std::unordered_map<std::string, DummyModelCost> model_costs_;
+    std::atomic<uint64_t> model_bytes_{0};  // 已加载模型占用的模拟设备内存
+    mutable std::mutex alloc_lock_;         // malloc只在内存池未命中时调用，加锁记录大小
+    std::unordered_map<void*, uint64_t> allocs_;
+    uint64_t alloc_bytes_{0};
+
+    std::mutex exec_lock_;               // 模拟max_concurrency个计算单元
+    std::condition_variable exec_cond_;
+    uint32_t executing_{0};
+
+    std::atomic<uint64_t> busy_us_{0};
+    std::mutex usage_lock_;
+    uint64_t last_busy_us_{0};
+    std::atomic<double> temperature_{kTemperatureIdle};
+    Clock::time_point last_sample_;
+
+    std::atomic<bool> has_script_{false};  // 推理路径上先看它，没有脚本时不加锁
+    mutable std::mutex script_lock_;
+    std::vector<DummyTelemetryPoint> script_;
+    Clock::time_point script_begin_;
+};
+
+class DummyModel : public Model {
+  public:
+    DummyModel(Backend* backend, std::unique_ptr<ModelInfo> info, DummyModelProfile profile)
+        : Model(backend, std::move(info)), profile_(std::move(profile)) { device_bytes_ = profile_.cost.size_bytes; }
+    const DummyModelProfile& getProfile() const { return profile_; }
+
+  private:
+    DummyModelProfile profile_;
 };
 
+// 用一个工作线程模拟设备上的stream，放入的操作按顺序异步执行
 class DummyStream : public Stream {
   public:
     DummyStream(Backend* backend) : Stream(backend) {}
-    virtual ~DummyStream() {}
+    virtual ~DummyStream() { destoryStream(); }
+    Result synchronize() override;
     Result createStream() override;
     Result destoryStream() override;
+    Result recordEvent(Event* event) override;
+    Result waitEvent(Event* event) override;
+    Result addCallback(std::function<void()> cb) override;
     void* getStream() override;
 
+    void enqueue(std::function<void()> op);
+
   private:
+    void loop();
+
     void* stream_{nullptr};
+    std::thread worker_;
+    std::mutex lock_;
+    std::condition_variable cond_;
+    std::condition_variable idle_cond_;
+    std::deque<std::function<void()>> ops_;
+    bool busy_{false};
+    bool stop_{false};
+};
+
+// record时序号加一，stream执行到该位置时标记完成
+class DummyEvent : public Event {
+  public:
+    DummyEvent(Backend* backend) : Event(backend) {}
+    virtual ~DummyEvent() {}
+    Result synchronize() override;
+    Result createEvent() override;
+    Result destoryEvent() override;
+    void* getEvent() override;
+
+    uint64_t record();
+    uint64_t latest();
+    void complete(uint64_t seq);
+    void waitFor(uint64_t seq);
+
+  private:
+    std::mutex lock_;
+    std::condition_variable cond_;
+    uint64_t recorded_{0};
+    uint64_t completed_{0};
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "model_info.h"
 #include <lyn_api.h>
 #include <lyn_smi.h>
+#include <lyn_memory_ex.h>
 
 class Lynxi : public Backend {
   public:
@@ -13,17 +14,24 @@ class Lynxi : public Backend {
 
     Result init() override;
     Result finalize() override;
+    Result bindThread() override;
     Result malloc(void **dev_ptr, uint64_t size) override;
     Result free(void *dev_prt) override;
+    Result mallocHost(void **host_ptr, size_t size) override;
+    Result freeHost(void *host_ptr) override;
     Result memcopy(void *dst, const void *src, uint64_t size, DIRECTION dir) override;
-    uint32_t loadModel(const std::string &path) override;
-    Result unloadModel(const std::string& path) override;
-    Result infer(Stream* stream, uint32_t model_id, void* dev_input_ptr, void* dev_output_ptr) override;
-    const ModelInfo* getModelInfo(uint32_t model_id) const override;
-    
+    Result memcopyAsync(Stream* stream, void *dst, const void *src, uint64_t size, DIRECTION dir) override;
+    Result infer(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) override;
+    Result inferAsync(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) override;
+
     std::unique_ptr<Stream> createStream() override;
     Result destoryStream(Stream* stream) override;
+    std::unique_ptr<Event> createEvent() override;
+    Result destoryEvent(Event* event) override;
 
+  protected:
+    std::unique_ptr<Model> loadModel(const std::string &path) override;
+    Result unloadModel(Model* model) override;
 
   private:
     lynContext_t ctx_{nullptr};
@@ -32,9 +40,10 @@ class Lynxi : public Backend {
 
 class LynxiModel : public Model {
   public:
-    LynxiModel(Backend* backend, lynModel_t model) : Model(backend), model_(model) {}
+    LynxiModel(Backend* backend, lynModel_t model, std::unique_ptr<ModelInfo> info)
+        : Model(backend, std::move(info)), model_(model) {}
     virtual ~LynxiModel() {}
-    void* getHandle() override;
+    void* getHandle() const override;
   private:
     lynModel_t model_;
 };
@@ -48,6 +57,7 @@ class LynxiStream : public Stream {
     Result destoryStream() override;
     Result recordEvent(Event* event) override;
     Result waitEvent(Event* event) override;
+    Result addCallback(std::function<void()> cb) override;
     void* getStream() override;
 
   private:
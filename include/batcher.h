@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.h"
+#include "task_queue.h"
+#include "tensor.h"
+#include <chrono>
+#include <deque>
+
+struct BatcherCfg {
+    uint32_t max_batch_delay_us = 0;              // 最早到达的请求最多等待多久
+    std::vector<uint32_t> preferred_batch_sizes;  // 攒到这些大小时不等deadline直接下发
+};
+
+// -----------------------------
+// Batcher 定义
+// 位于Session和TaskQueue之间，把单样本Task合并成模型的一个batch
+// 不足一个batch时补零，输出按样本切开后分别回调
+// -----------------------------
+class Batcher {
+  public:
+    Batcher(TaskQueue* tq, size_t max_batch, const BatcherCfg& cfg);
+    ~Batcher();
+
+    void start();
+    // 提交一个单样本任务
+    void submit(Task task);
+    // 下发所有剩余任务后退出
+    void stop();
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    struct Pending {
+        Task task;
+        Clock::time_point arrival;
+    };
+
+    void loop();
+    bool isPreferred(size_t n) const;
+    void dispatch(std::vector<Pending>&& batch);
+
+    TaskQueue* tq_;
+    size_t max_batch_;
+    BatcherCfg cfg_;
+
+    std::mutex lock_;
+    std::condition_variable cond_;
+    std::deque<Pending> pending_;
+    std::thread worker_;
+    bool stop_{false};
+};
@@ -19,16 +19,16 @@
 #include <cstring>
 #include <algorithm>
 
+#include "logger.h"
+
 // INFO_LOG("info %d %d", 8, num);
-#define INFO_LOG(fmt, ...) fprintf(stdout, "[INFO]  " fmt "\n", ##__VA_ARGS__)
-#define WARN_LOG(fmt, ...) fprintf(stdout, "[WARN]  " fmt "\n", ##__VA_ARGS__)
-#define ERROR_LOG(fmt, ...) fprintf(stderr, "[ERROR]  " fmt "\n", ##__VA_ARGS__)
+// 日志宏定义在logger.h，级别低于LOG_LEVEL的在编译期去掉
 
 #define RETURN_IF_ERR(expr, msg)                           \
   do {                                                     \
     auto err__ = (expr);                                   \
     if (err__ != SUCCESS) {                                \
-      std::cerr << "[ERROR] " << #expr << " failed: " << msg << std::endl; \
+      ERROR_LOG("%s failed: %s", #expr, msg);              \
       return err__;                                        \
     }                                                      \
   } while (0)
@@ -40,6 +40,7 @@ enum DataType {
   INT8,
   UINT8,
   FLOAT16,
+  BFLOAT16,
 };
 
 enum Result {
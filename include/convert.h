@@ -0,0 +1,43 @@
+#pragma once
+
+#include "common.h"
+
+// -----------------------------
+// 数据类型转换：fp32 <-> fp16 / bf16 / int8 / uint8
+// x86上用F16C/AVX2(运行时检测)，aarch64上用NEON，否则为标量实现；舍入方式均为就近取偶
+// 量化: q = clamp(round(x / scale) + zero_point)，反量化: x = (q - zero_point) * scale
+// -----------------------------
+
+struct QuantParam {
+    float scale = 1.0f;
+    int zero_point = 0;
+};
+
+// 当前使用的指令集，"f16c+avx2" / "neon" / "scalar"
+const char* convertSimdName();
+
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+uint16_t floatToBf16(float value);
+float bf16ToFloat(uint16_t value);
+
+void floatToHalf(const float* src, uint16_t* dst, size_t n);
+void halfToFloat(const uint16_t* src, float* dst, size_t n);
+void floatToBf16(const float* src, uint16_t* dst, size_t n);
+void bf16ToFloat(const uint16_t* src, float* dst, size_t n);
+
+void quantizeInt8(const float* src, int8_t* dst, size_t n, QuantParam q);
+void dequantizeInt8(const int8_t* src, float* dst, size_t n, QuantParam q);
+void quantizeUint8(const float* src, uint8_t* dst, size_t n, QuantParam q);
+void dequantizeUint8(const uint8_t* src, float* dst, size_t n, QuantParam q);
+
+// 按通道量化，数据布局为[channels, inner]，每个通道一组参数
+void quantizeInt8PerChannel(const float* src, int8_t* dst, size_t channels, size_t inner,
+                            const QuantParam* params);
+void dequantizeInt8PerChannel(const int8_t* src, float* dst, size_t channels, size_t inner,
+                              const QuantParam* params);
+
+// 任意两种类型之间转换count个元素，非float32之间的转换分块经过float32中转
+// 整数类型用q做量化参数，浮点类型忽略q
+Result convertBuffer(const void* src, DataType src_type, void* dst, DataType dst_type, size_t count,
+                     QuantParam q = {});
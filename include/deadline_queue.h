@@ -0,0 +1,71 @@
+#pragma once
+
+#include "common.h"
+#include "task_queue.h"
+#include "profiler.h"
+
+struct SchedulerCfg {
+    std::string policy = "fifo";    // fifo | edf | steal
+    int lanes = 2;                  // 优先级通道数，priority超出范围的归到最后一个通道
+    uint32_t aging_ms = 100;        // 低优先级通道的任务等待超过该值后优先服务，0为严格按优先级
+    size_t capacity = 4096;         // 所有通道合计，满时push阻塞
+    std::string stats_output;       // 非空时stop时把各通道统计写到该JSON文件
+};
+
+// -----------------------------
+// DeadlineQueue 定义
+// 按优先级分通道，通道内按deadline最早的先出(EDF)，没有deadline的任务按入队时间+aging_ms排序；
+// 低优先级通道的任务等待超过aging_ms后先于高优先级服务，避免批量任务饿死；
+// 出队时已经超过deadline的任务直接丢弃(TASK_EXPIRED)，不占用设备
+// 用一把锁保护所有通道，吞吐低于FifoTaskQueue，见bench/task_queue_bench
+// -----------------------------
+class DeadlineQueue : public TaskQueue {
+  public:
+    explicit DeadlineQueue(const SchedulerCfg& cfg = SchedulerCfg{});
+    ~DeadlineQueue() = default;
+
+    void push(Task task) override;
+    bool pop(Task& task_out) override;
+    void shutdown() override;
+    size_t size() const override;
+
+    // 各通道的提交、完成、丢弃计数和端到端延迟分位数
+    std::string toJson() const;
+    void logStats() const;
+
+  private:
+    struct Item {
+        Task task;
+        uint64_t key;               // 排序用的deadline
+        uint64_t seq;               // key相同时按入队顺序
+    };
+    struct Lane {
+        std::vector<Item> heap;     // 最小堆，受lock_保护
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> missed{0};    // 完成了但晚于deadline
+        std::atomic<uint64_t> expired{0};
+        std::atomic<uint64_t> failed{0};
+        LatencyHistogram latency;           // 入队到回调，只统计完成的任务
+    };
+
+    // 在lock_内调用，返回下一个要服务的通道，全空时返回-1
+    int pickLane(uint64_t now) const;
+    // 在lock_内调用，把各通道队头已过期的任务移到expired
+    void collectExpired(uint64_t now, std::vector<Task>& expired);
+    Item popLane(int lane);
+
+    SchedulerCfg cfg_;
+    uint64_t aging_ns_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+
+    mutable std::mutex lock_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    size_t size_{0};
+    uint64_t seq_{0};
+    bool stop_{false};
+};
+
+// 按配置创建TaskQueue，num_workers为从队列取任务的executor数
+std::unique_ptr<TaskQueue> makeTaskQueue(const SchedulerCfg& cfg, int num_workers);
@@ -4,36 +4,108 @@
 #include "backend/backend.h"
 #include "model_info.h"
 #include "backend/lynxi.h"
+#include "memory_pool.h"
 #include "task_queue.h"
 #include "tensor.h"
+#include "profiler.h"
+#include "model_manager.h"
+#include "governor.h"
 
 class Executor {
   public:
-    Executor(const std::string& model_path, Backend* backend, TaskQueue* tq, int id, DataType otype);
+    Executor(const std::string& model_path, Backend* backend, TaskQueue* tq, int id, DataType otype,
+             int pipeline_depth = 1, Profiler* profiler = nullptr);
     ~Executor();
     Result Execute();
+    // 一个设备上服务多个模型时设置，需要在Execute之前调用
+    void setModelManager(ModelManager* manager) { manager_ = manager; }
+    // 按设备温度/显存限流时设置，需要在Execute之前调用
+    void setGovernor(Governor* governor) { governor_ = governor; }
+    int getId() const { return id_; }
+    Backend* getBackend() const { return backend_; }
+    // Execute是因为取到退出任务(缩容)而返回的
+    bool retired() const { return retired_; }
+    // 至少有一个任务在执行的累计时间(流水线模式含正在进行的这一段)，和完成的任务数，供telemetry和autoscaler采样
+    uint64_t busyNs() const;
+    uint64_t tasksDone() const { return tasks_done_.load(std::memory_order_relaxed); }
     
     private:
     int id_;
     Backend* backend_;
     std::string model_path_;
     TaskQueue* tq_;
-    uint32_t model_id_{0};
+    ModelHandle model_;               // 持有期间模型不会被卸载，推理直接用它，不查表
+    ModelManager* manager_{nullptr};  // 为空时直接从backend加载
+    Governor* governor_{nullptr};     // 为空时不限流
+    bool retired_{false};
+    std::atomic<uint64_t> busy_ns_{0};
+    std::atomic<uint64_t> tasks_done_{0};
     
     const ModelInfo* info_{nullptr};
     std::unique_ptr<Stream> stream_;
     
     void* dev_input_ptr_{nullptr};
     void* dev_output_ptr_{nullptr};
+    size_t dev_input_size_{0};
+    size_t dev_output_size_{0};
+    std::unique_ptr<PoolCache> pool_cache_; // 本地设备内存缓存，命中时不加锁
     DataType output_type_; // bad, for now
+
+    // 流水线模式：一个在途任务占一个slot，H2D/推理/D2H分别在三个stream上，用event交接
+    struct Slot {
+        Task task;
+        void* dev_input_ptr{nullptr};
+        void* dev_output_ptr{nullptr};
+        std::vector<Tensor> outputs;
+        std::unique_ptr<Event> h2d_done;
+        std::unique_ptr<Event> infer_done;
+        bool busy{false};
+        int callbacks{0};            // 还没执行完的stream回调数，受slot_lock_保护；异步回调不阻塞stream，同步stream不能保证它们已执行
+        // 由stream回调写入，回调线程和D2H回调之间没有顺序保证
+        std::atomic<uint64_t> h2d_end{0};
+        std::atomic<uint64_t> infer_end{0};
+    };
+    int pipeline_depth_;
+    Profiler* profiler_;             // 为空表示不做性能统计
+    std::unique_ptr<Stream> h2d_stream_;
+    std::unique_ptr<Stream> d2h_stream_;
+    std::vector<Slot> slots_;
+    size_t next_slot_{0};
+    int active_slots_{0};            // 受slot_lock_保护，从0变1时开始计忙
+    std::atomic<uint64_t> busy_since_{0};  // 流水线当前这段忙碌的开始时刻，0表示空闲
+    std::mutex slot_lock_;
+    std::condition_variable slot_cond_;
+
+    // 取任务前先向governor要在途名额，设备被限流时在这里等，不占用队列里的任务
+    bool nextTask(Task& task);
+    // 任务完成、丢弃或取到退出任务后归还名额
+    void taskFinished();
+    Result executePipelined();
+    Result initPipeline();
+    Result finalizePipeline();
+    Result submitSlot(Slot& slot);
+    // 给slot加stream回调并计数，slot要等busy和回调都结束才能复用或释放
+    Result addSlotCallback(Stream* stream, Slot& slot, std::function<void()> fn);
+    // 等所有slot都没有在途任务和未执行的回调，调用方持有slot_lock_
+    void waitSlotsIdle(std::unique_lock<std::mutex>& lock);
+    // 等流水线的三个stream上已入队的操作执行完
+    void synchronizeStreams();
+    Slot& acquireSlot();
+    void releaseSlot(Slot& slot);
     
     Result loadModel();
     Result unloadModel();
+    // 任务指定了别的模型时切换，流水线模式下先等在途任务完成再按新模型重新分配slot内存；失败时保持原模型
+    Result switchModel(const std::string& path);
+    Result acquireSlotBuffers();
+    void releaseSlotBuffers();
     Result init();
     Result run();
     Result finalize();
+    Result checkInput(const std::vector<Tensor>& inputs);
     Result prepareInput(std::vector<Tensor>&&);
     Result prepareOutput();
     void destroyBuffers();
+    std::vector<Tensor> allocOutputs();
     std::vector<Tensor> getOutput();
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "common.h"
+#include "backend/backend.h"
+#include <map>
+
+struct GovernorCfg {
+    uint32_t interval_ms = 100;      // 采样设备温度和显存的周期；Telemetry在运行时读它按自己周期刷新的值
+    int32_t temp_margin = 10;        // 距停止温度不到该值时在途深度减半
+    int32_t temp_critical = 3;       // 距停止温度不到该值时暂停该设备(其他设备都过热时保留min_depth)
+    double mem_high = 0.85;          // 显存占用比例，含义同temp_margin
+    double mem_critical = 0.95;      // 含义同temp_critical
+    int32_t temp_hysteresis = 2;     // 降级时要多退的温度，避免在阈值附近来回切换
+    double mem_hysteresis = 0.03;
+    int min_depth = 1;
+    std::string events_output;       // 非空时stop后把限流事件写成JSON
+};
+
+enum ThrottleLevel {
+    THROTTLE_NONE,
+    THROTTLE_SOFT,                   // 在途深度减半
+    THROTTLE_HARD,                   // 暂停或只留min_depth
+};
+
+struct ThrottleEvent {
+    uint64_t ts;                     // Profiler::now()的ns
+    std::string device;              // 如 dummy:1
+    ThrottleLevel from;
+    ThrottleLevel to;
+    int32_t temperature;
+    int32_t temperature_limit;
+    double memory_rate;
+    int depth;                       // 切换后的在途上限，-1为不限
+};
+
+// -----------------------------
+// Governor 定义
+// 按Monitor采到的温度和显存占用给每个设备定一个在途任务上限：
+// executor取任务前acquire，设备到上限时阻塞，不再从共享队列(或自己的分片)取任务，
+// 新任务因此由同一队列上其他较凉、较空的设备的executor取走
+// 每次级别变化记一条ThrottleEvent
+// -----------------------------
+class Governor {
+  public:
+    explicit Governor(const GovernorCfg& cfg);
+    ~Governor();
+
+    void start();
+    // stop后acquire不再阻塞，已经阻塞的被唤醒
+    void stop();
+    // 采样一次并调整上限，采样线程也调用它
+    void evaluate();
+
+    // executor开始/结束在设备上服务时调用，depth为它最多同时在途的任务数
+    void attach(Backend* backend, int depth);
+    void detach(Backend* backend, int depth);
+    // executor取任务前调用，达到上限时等待；release在任务完成或丢弃后调用
+    void acquire(Backend* backend);
+    void release(Backend* backend);
+
+    ThrottleLevel level(Backend* backend) const;
+    std::vector<ThrottleEvent> events() const;
+    void logStats() const;
+    std::string toJson() const;
+
+  private:
+    struct Device {
+        std::string name;
+        int capacity{0};             // attach的executor深度之和
+        int inflight{0};
+        int limit{-1};               // 当前在途上限，-1为不限
+        ThrottleLevel level{THROTTLE_NONE};
+        uint64_t level_since{0};
+        uint64_t throttled_ns{0};    // 处于SOFT/HARD的累计时间
+        uint64_t waits{0};           // acquire需要等待的次数
+    };
+
+    Device& device(Backend* backend);
+    // 按各设备的级别和capacity重算limit，调用方持有lock_
+    void updateLimits();
+    ThrottleLevel classify(ThrottleLevel current, int32_t headroom, double memory_rate) const;
+    void loop();
+
+    GovernorCfg cfg_;
+    mutable std::mutex lock_;
+    std::condition_variable cond_;
+    std::map<Backend*, Device> devices_;
+    std::vector<ThrottleEvent> events_;
+    bool stop_{true};
+    std::thread worker_;
+    int collector_id_{-1};
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common.h"
+#include "preprocessor.h"
+
+// 图像预处理描述，对应session yaml中的image_pipeline
+struct ImagePipelineCfg {
+    int resize_short = 0;                    // 短边缩放到该值，0为不缩放
+    int crop_h = 0;                          // 中心裁剪，0为不裁剪
+    int crop_w = 0;
+    float scale = 1.0f / 255.0f;             // 先乘scale，再减mean除std
+    std::vector<float> mean{0.0f, 0.0f, 0.0f};
+    std::vector<float> std{1.0f, 1.0f, 1.0f};
+    bool to_rgb = true;                      // 输入是imread解码出的BGR
+    bool chw = true;                         // 输出布局，false为HWC
+    DataType dtype = FLOAT32;                // float32 / float16 / bfloat16 / int8 / uint8
+    float quant_scale = 1.0f;                // int8/uint8输出: q = round(v / quant_scale)
+};
+
+// -----------------------------
+// ImagePipeline 定义
+// 把缩放、裁剪、通道交换、归一化、HWC->CHW、类型转换融合成一次遍历，
+// 直接从解码后的uint8 HWC图像写到目标缓冲。
+// 缩放为定点双线性(与cv::resize INTER_LINEAR一致，结果先取整为uint8)，
+// 因此归一化和类型转换可以预先算成每个通道256项的查找表。
+// 按输出行处理，横向插值后的源行会缓存复用，纵向混合用AVX2/NEON
+// -----------------------------
+class ImagePipeline {
+  public:
+    explicit ImagePipeline(const ImagePipelineCfg& cfg);
+
+    // 输入为src_h x src_w的3通道图像时输出的形状(不含batch)和字节数
+    std::vector<uint32_t> outputShape(int src_h, int src_w) const;
+    size_t outputSize(int src_h, int src_w) const;
+
+    // src为3通道uint8 HWC，src_stride为每行字节数；dst至少outputSize字节
+    Result run(const uint8_t* src, int src_h, int src_w, size_t src_stride, void* dst) const;
+
+    // 生成可以注册给Session的预处理函数，参数为图片路径，用cv::imread解码
+    PreprocessFn makePreprocessFn() const;
+
+  private:
+    struct Geometry;
+
+    void resizedSize(int src_h, int src_w, int& h, int& w) const;
+    std::shared_ptr<const Geometry> geometry(int src_h, int src_w) const;
+    template <typename T>
+    void runTyped(const uint8_t* src, size_t src_stride, const Geometry& geo, T* dst) const;
+
+    ImagePipelineCfg cfg_;
+    std::vector<uint8_t> lut_;               // 3 x 256 x 元素大小
+    size_t elem_size_;
+
+    mutable std::mutex geo_lock_;
+    mutable std::vector<std::shared_ptr<const Geometry>> geo_cache_;
+};
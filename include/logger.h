@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// 编译期日志级别，低于LOG_LEVEL的宏展开为空语句，参数也不会求值
+// Release(NDEBUG)默认只保留WARN和ERROR，可以用 -DLOG_LEVEL=LOG_LEVEL_DEBUG 覆盖
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF   4
+
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL LOG_LEVEL_WARN
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+// 每个日志调用点一个，用于限速
+struct LogSite {
+    std::atomic<uint64_t> window{0};       // 当前统计窗口(秒)
+    std::atomic<uint32_t> count{0};        // 窗口内已输出的条数
+    std::atomic<uint32_t> suppressed{0};   // 被限速丢掉的条数
+};
+
+// -----------------------------
+// Logger 定义
+// 异步模式下调用线程只格式化并写入无锁环形队列，后台线程负责写stdout/stderr
+// 队列满时丢弃(ERROR除外，直接同步写)，不会阻塞调用线程
+// -----------------------------
+class Logger {
+  public:
+    static Logger* getInstance();
+
+    void log(int level, LogSite* site, const char* fmt, ...) __attribute__((format(printf, 4, 5)));
+
+    // 运行时级别，只能比编译期级别更严格
+    bool enabled(int level) const { return level >= level_.load(std::memory_order_relaxed); }
+    void setLevel(int level) { level_.store(level, std::memory_order_relaxed); }
+    void setAsync(bool async);
+    // 每个调用点每秒最多输出多少条，0表示不限
+    void setRateLimit(uint32_t per_sec) { rate_limit_.store(per_sec, std::memory_order_relaxed); }
+    // 等待队列中的日志全部写出
+    void flush();
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static int levelFromString(const std::string& str);
+
+  private:
+    Logger();
+    ~Logger() = delete;  // 进程退出前一直可用，atexit时关闭后台线程
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    struct Impl;
+
+    bool allow(LogSite* site);
+    void emit(int level, const char* text, size_t len);
+    void shutdown();
+
+    std::atomic<int> level_{LOG_LEVEL};
+    std::atomic<uint32_t> rate_limit_{1000};
+    std::atomic<uint64_t> dropped_{0};
+    Impl* impl_;
+};
+
+#define LOG_AT(level, fmt, ...)                                              \
+  do {                                                                       \
+    if (Logger::getInstance()->enabled(level)) {                             \
+      static LogSite log_site__;                                             \
+      Logger::getInstance()->log(level, &log_site__, fmt, ##__VA_ARGS__);    \
+    }                                                                        \
+  } while (0)
+
+// 被裁掉的级别不生成任何代码，但仍然做格式串检查，也不会引入未使用变量的警告
+#define LOG_NOTHING(fmt, ...) do { if (0) fprintf(stdout, fmt, ##__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define DEBUG_LOG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, "[DEBUG] " fmt "\n", ##__VA_ARGS__)
+#else
+#define DEBUG_LOG(fmt, ...) LOG_NOTHING(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define INFO_LOG(fmt, ...) LOG_AT(LOG_LEVEL_INFO, "[INFO]  " fmt "\n", ##__VA_ARGS__)
+#else
+#define INFO_LOG(fmt, ...) LOG_NOTHING(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define WARN_LOG(fmt, ...) LOG_AT(LOG_LEVEL_WARN, "[WARN]  " fmt "\n", ##__VA_ARGS__)
+#else
+#define WARN_LOG(fmt, ...) LOG_NOTHING(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define ERROR_LOG(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, "[ERROR]  " fmt "\n", ##__VA_ARGS__)
+#else
+#define ERROR_LOG(fmt, ...) LOG_NOTHING(fmt, ##__VA_ARGS__)
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "common.h"
+
+class Backend;
+
+// -----------------------------
+// MemoryPool 定义
+// 按2的幂次分桶缓存设备内存，每个Backend持有一个，所有executor共享
+// 底层仍通过Backend::malloc/free申请和释放，因此对Dummy和Lynxi都适用
+// host为true时管理的是后端的主机锁页内存(Backend::mallocHost/freeHost)
+// -----------------------------
+class MemoryPool {
+  public:
+    struct Stats {
+        uint64_t hits;          // 命中缓存(包括executor本地缓存)的次数
+        uint64_t misses;        // 需要调用Backend::malloc的次数
+        uint64_t bytes_held;    // 池中空闲、尚未归还后端的字节数
+        uint64_t bytes_in_use;  // 已借出的字节数
+        float hitRate() const {
+            auto total = hits + misses;
+            return total == 0 ? 0.0f : (float)hits / (float)total;
+        }
+    };
+
+    explicit MemoryPool(Backend* backend, bool host = false) : backend_(backend), host_(host) {}
+    ~MemoryPool() = default;
+
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    // 返回至少bucketSize(size)字节的设备内存，失败返回nullptr
+    void* acquire(size_t size);
+    // size必须与acquire时传入的大小落在同一个桶中
+    void release(void* dev_ptr, size_t size);
+    // 把所有空闲块归还给后端，需在后端context销毁前调用
+    void trim();
+
+    Stats getStats() const;
+
+    static size_t bucketSize(size_t size);
+
+  private:
+    friend class PoolCache;
+    static constexpr int kMinShift = 8;   // 最小桶256B
+    static constexpr int kNumBuckets = 40;
+
+    static int bucketIndex(size_t size);
+
+    Backend* backend_;
+    bool host_;
+    std::mutex lock_;
+    std::vector<void*> free_lists_[kNumBuckets];
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> bytes_held_{0};
+    std::atomic<uint64_t> bytes_in_use_{0};
+};
+
+// -----------------------------
+// PoolCache 定义
+// executor独占的小缓存，命中时不需要加锁
+// -----------------------------
+class PoolCache {
+  public:
+    explicit PoolCache(MemoryPool* pool, size_t capacity = 4)
+    : pool_(pool), capacity_(capacity) {
+        blocks_.reserve(capacity_);
+    }
+    ~PoolCache() { flush(); }
+
+    PoolCache(const PoolCache&) = delete;
+    PoolCache& operator=(const PoolCache&) = delete;
+
+    void* acquire(size_t size);
+    void release(void* dev_ptr, size_t size);
+    // 把本地缓存的块全部还给MemoryPool
+    void flush();
+
+  private:
+    struct Block {
+        void* ptr;
+        size_t bucket_size;
+    };
+
+    MemoryPool* pool_;
+    size_t capacity_;
+    std::vector<Block> blocks_;
+};
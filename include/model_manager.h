@@ -0,0 +1,72 @@
+#pragma once
+
+#include "common.h"
+#include "backend/backend.h"
+
+enum EvictPolicy {
+    EVICT_LRU,   // 最久未使用的先淘汰
+    EVICT_LFU,   // 使用次数最少的先淘汰，次数相同时按LRU
+};
+
+EvictPolicy stringToEvictPolicy(const std::string& str);
+
+struct ModelManagerCfg {
+    float watermark = 0.9f;          // 设备内存使用率超过该值时淘汰冷模型
+    EvictPolicy policy = EVICT_LRU;
+    size_t max_resident = 0;         // 常驻模型数上限，0为只看内存
+    std::vector<std::string> preload;  // 启动时加载并常驻，不参与淘汰
+};
+
+struct ModelStats {
+    std::string path;
+    uint64_t hits{0};                // 请求时已在设备上
+    uint64_t loads{0};               // 请求时需要(重新)加载
+    uint64_t evictions{0};
+    uint64_t load_us{0};             // 累计加载耗时
+    uint64_t device_bytes{0};        // 最近一次加载的设备内存占用
+    bool resident{false};
+    bool pinned{false};
+};
+
+// -----------------------------
+// 一张卡上服务多个模型：热模型常驻，设备内存接近水位线时按LRU/LFU淘汰冷模型，再次请求时重新加载
+// 管理器自己持有常驻模型的句柄；淘汰只是放掉这个句柄，还有executor在用的模型等它们用完才真正卸载，
+// 所以正在推理的模型不会被选中(腾不出内存)
+// -----------------------------
+class ModelManager {
+  public:
+    ModelManager(Backend* backend, const ModelManagerCfg& cfg);
+    ~ModelManager();
+
+    // 不在设备上时先腾出内存再加载，加载耗时计入统计；失败返回空
+    ModelHandle get(const std::string& path);
+    // 加载并常驻，不参与淘汰
+    Result pin(const std::string& path);
+    void unpin(const std::string& path);
+
+    std::vector<ModelStats> stats() const;
+    size_t residentCount() const;
+    Backend* getBackend() { return backend_; }
+
+  private:
+    struct Entry {
+        ModelHandle handle;          // 为空表示已被淘汰
+        uint64_t last_use{0};
+        uint64_t uses{0};
+        ModelStats stats;
+    };
+
+    // 设备内存使用量和总量，优先用Monitor的Prop，取不到时只按已知模型大小估算
+    void memoryUsage(uint64_t& used, uint64_t& total) const;
+    // 为extra字节腾出空间，在lock_内调用
+    void makeRoom(uint64_t extra, const std::string& keep);
+    // 选一个可以淘汰的模型，没有时返回nullptr
+    Entry* pickVictim(const std::string& keep);
+    void evict(Entry& entry);
+
+    Backend* backend_;
+    ModelManagerCfg cfg_;
+    mutable std::mutex lock_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t clock_{0};              // 逻辑时钟，每次get加一
+};
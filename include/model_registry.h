@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.h"
+#include <unordered_set>
+
+class Model;
+
+// 模型句柄，引用计数归零时registry卸载模型；持有句柄期间Model及其原生句柄一直有效
+using ModelHandle = std::shared_ptr<Model>;
+
+// -----------------------------
+// 每个后端一个ModelRegistry
+// 同一路径只加载一次，所有句柄释放后才卸载，executor各自持有句柄，不会卸载掉别人还在用的模型
+// 按id查找读的是不可变快照(写时复制)，不加锁；推理路径上executor直接用缓存的句柄，不查找
+// -----------------------------
+class ModelRegistry {
+  public:
+    using Loader = std::function<std::unique_ptr<Model>(const std::string& path)>;
+    using Unloader = std::function<void(Model* model)>;
+
+    ModelRegistry(Loader loader, Unloader unloader)
+        : loader_(std::move(loader)), unloader_(std::move(unloader)),
+          snapshot_(std::make_shared<const Snapshot>()) {}
+    // 析构前所有句柄都要释放，否则句柄的释放函数会访问已析构的registry
+    ~ModelRegistry();
+
+    // 已加载则增加引用，正在加载或正在卸载则等待；加载失败返回空
+    ModelHandle acquire(const std::string& path);
+    // 不加锁，返回的指针只在有人持有该模型句柄期间有效
+    const Model* find(uint32_t id) const;
+    size_t size() const { return std::atomic_load(&snapshot_)->size(); }
+
+  private:
+    using Snapshot = std::unordered_map<uint32_t, const Model*>;
+
+    void release(Model* model);
+    // 在lock_内调用，复制一份快照修改后发布
+    void publish(uint32_t id, const Model* model);
+
+    Loader loader_;
+    Unloader unloader_;
+
+    std::mutex lock_;                 // 只有加载和卸载时使用
+    std::condition_variable cond_;
+    std::unordered_map<std::string, std::weak_ptr<Model>> by_path_;
+    std::unordered_set<std::string> busy_;  // 正在加载或卸载的路径
+    uint32_t next_id_{0};
+
+    std::shared_ptr<const Snapshot> snapshot_;  // 用std::atomic_load/atomic_store读写
+};
@@ -3,16 +3,21 @@
 #include "backend/backend.h"
 #include "backend/lynxi.h"
 #include "backend/dummy.h"
+#include "backend/cpu.h"
+#include "telemetry.h"
+#include <map>
 
 class BackendFactory {
   public:
-    static std::unique_ptr<Backend> createBackend(BackendType type) {
+    static std::unique_ptr<Backend> createBackend(BackendType type, int device_id = 0) {
         switch (type) {
             case BACKEND_LYNXI: {
-                int cnt;
+                int cnt = 0;
                 lynGetDeviceCount(&cnt);
-                assert(cnt != 0);
-                int device_id = 0; // hard code
+                if (device_id < 0 || device_id >= cnt) {
+                  ERROR_LOG("lynxi设备id %d 超出范围, 设备数为%d", device_id, cnt);
+                  return nullptr;
+                }
                 auto backend = std::make_unique<Lynxi>(device_id);
                 auto res = backend->init();
                 if (res == FAIL) {
@@ -21,20 +26,28 @@ class BackendFactory {
                 return backend;
             }
             case BACKEND_DUMMY:
-                return std::make_unique<Dummy>();
+                // dummy设备不限数量，每个id一个实例
+                return std::make_unique<Dummy>(device_id);
+            case BAKCEND_CPU:
+                // 线程池在init里创建，Session设置线程数后再init
+                return std::make_unique<Cpu>(device_id);
             default:
                 return nullptr;
         }
     }
 };
 
+// 日志和指标标签里的设备名，如 dummy:1
+std::string deviceLabel(BackendType type, int id);
+
 class Prop {
   public:
-    Prop(BackendType t, int id) : type(t), dev_id(id) {}
+    Prop(BackendType t, int id, Backend* b = nullptr) : type(t), dev_id(id), backend(b) {}
     ~Prop() = default;
 
     BackendType type;
     int dev_id;
+    Backend* backend;
 
     uint64_t memory_used{};
     uint64_t memory_total{};
@@ -54,26 +67,28 @@ class Monitor {
         return &monitor;
     }
 
-    Backend* getBackend(BackendType type);
-    float getMemUsedRate(BackendType type);
+    // 同一(type, device_id)只创建一个Backend
+    Backend* getBackend(BackendType type, int device_id = 0);
+    // 返回设备属性的拷贝，设备未创建时返回的backend为nullptr
+    // Telemetry在运行时只由它的采样线程刷新，这里读缓存值；否则按需刷新
+    Prop getProp(BackendType type, int device_id = 0);
+    float getMemUsedRate(BackendType type, int device_id = 0);
 
   private:
     Monitor() {
       init();
     }
     ~Monitor() {
-      stop_ = true;
-      if (monitor_thread_.joinable()) {
-        monitor_thread_.join();
-      }
+      Telemetry::getInstance()->removeCollector(collector_id_);
     }
 
     Monitor(const Monitor&) = delete;
     Monitor& operator=(const Monitor&) = delete;
 
     Result init();
-    std::unordered_map<BackendType, std::unique_ptr<Backend>> backends_;
-    std::unordered_map<BackendType, Prop> props_;
-    std::thread monitor_thread_;
-    std::atomic<bool> stop_;
+    using DeviceKey = std::pair<BackendType, int>;
+    std::mutex lock_;
+    std::map<DeviceKey, std::unique_ptr<Backend>> backends_;
+    std::map<DeviceKey, Prop> props_;
+    int collector_id_{-1};
 };
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common.h"
+#include "backend/backend.h"
+
+enum PlacementPolicy {
+    PLACE_ROUND_ROBIN,   // 按设备顺序轮流放
+    PLACE_WEIGHTED,      // 按weight比例分配executor
+    PLACE_LEAST_LOADED,  // 结合weight和Monitor采样到的使用率、显存占用
+};
+
+PlacementPolicy stringToPlacementPolicy(const std::string& str);
+
+struct DeviceCfg {
+    std::string type = "dummy";
+    int id = 0;
+    float weight = 1.0f;  // weighted和least_loaded策略使用
+    double speed = 1.0;   // 只对dummy生效，模拟不同算力的卡
+    int numa = -1;        // 设备所在的NUMA节点，affinity按numa绑核时使用，-1为按设备顺序轮流分到各节点
+};
+
+// -----------------------------
+// Placement 定义
+// 决定每个executor放到哪个设备上，executor之间仍共享一个TaskQueue，
+// 因此快的设备上的executor自然会取走更多任务
+// -----------------------------
+class Placement {
+  public:
+    // 返回长度为num_executor的列表，第i个executor放在result[i]上
+    static std::vector<Backend*> assign(const std::vector<Backend*>& backends,
+                                        const std::vector<float>& weights,
+                                        int num_executor, PlacementPolicy policy);
+
+  private:
+    static std::vector<Backend*> roundRobin(const std::vector<Backend*>& backends, int num_executor);
+    static std::vector<Backend*> weighted(const std::vector<Backend*>& backends,
+                                          const std::vector<float>& weights, int num_executor);
+    static std::vector<Backend*> leastLoaded(const std::vector<Backend*>& backends,
+                                             const std::vector<float>& weights, int num_executor);
+};
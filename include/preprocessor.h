@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common.h"
+#include <any>
+#include <deque>
+
+using PreprocessFn = std::function<std::vector<uint8_t>(const std::any&)>;
+
+struct PreprocessCfg {
+    size_t num_workers = 0;      // 0表示在调用线程上串行预处理
+    size_t max_pending = 16;     // 已提交但下游任务还没完成的最大数量
+    bool shed = false;           // 超过max_pending时丢弃新请求，否则阻塞提交方
+};
+
+// -----------------------------
+// Preprocessor 定义
+// 预处理作为单独的流水线阶段，在自己的线程池上执行，结果交给sink(通常是提交到TaskQueue)
+// 名额在submit时占用，下游任务完成后调用release归还，executor跟不上时提交方阻塞或丢弃
+// -----------------------------
+class Preprocessor {
+  public:
+    using Sink = std::function<void(std::vector<uint8_t>&&)>;
+
+    Preprocessor(PreprocessFn fn, const PreprocessCfg& cfg);
+    ~Preprocessor();
+
+    // init在每个worker线程开始时调用，参数为worker编号，用来绑核和设置线程名
+    void start(std::function<void(size_t)> init = nullptr);
+    // 返回false表示请求被丢弃，sink不会被调用
+    bool submit(std::any arg, Sink sink);
+    // 下游处理完一个请求(或者预处理失败)时归还名额
+    void release();
+    // 等待已提交的预处理全部完成后回收线程，之后不能再submit
+    void stop();
+
+    uint64_t shedCount() const { return shed_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Job {
+        std::any arg;
+        Sink sink;
+    };
+
+    void loop(size_t index, std::function<void(size_t)> init);
+    void run(Job& job);
+
+    PreprocessFn fn_;
+    PreprocessCfg cfg_;
+
+    std::mutex lock_;
+    std::condition_variable job_cond_;     // 通知worker有新任务
+    std::condition_variable slot_cond_;    // 通知提交方有空闲名额
+    std::deque<Job> jobs_;
+    size_t pending_{0};
+    bool stop_{false};
+    std::vector<std::thread> workers_;
+    std::atomic<uint64_t> shed_{0};
+};
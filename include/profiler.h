@@ -0,0 +1,107 @@
+#pragma once
+
+#include "common.h"
+#include <chrono>
+
+// 一个任务经过的各个阶段，TOTAL为入队到回调结束
+enum ProfileStage {
+    STAGE_QUEUE,
+    STAGE_H2D,
+    STAGE_INFER,
+    STAGE_D2H,
+    STAGE_CALLBACK,
+    STAGE_TOTAL,
+    STAGE_NUM,
+};
+
+const char* stageName(ProfileStage stage);
+
+// 任务各阶段的时间戳(ns，steady_clock)，为0表示没有记录
+struct TaskTimes {
+    uint64_t enqueue{0};
+    uint64_t dequeue{0};
+    uint64_t h2d_begin{0};
+    uint64_t h2d_end{0};
+    uint64_t infer_end{0};
+    uint64_t d2h_end{0};
+    uint64_t cb_end{0};
+};
+
+struct ProfilerCfg {
+    bool enable = false;
+    std::string output = "profile.json";
+    std::string format = "json";          // json | chrome
+    size_t max_trace_events = 100000;     // chrome格式最多保留多少个任务
+};
+
+// -----------------------------
+// LatencyHistogram 定义
+// 对数线性分桶(类似HDR Histogram)：每个2的幂区间再均分16格，相对误差不超过1/16
+// record只做relaxed原子加，多个线程可以并发写
+// -----------------------------
+class LatencyHistogram {
+  public:
+    LatencyHistogram();
+
+    void record(uint64_t ns);
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const;
+    // p取0~100，返回所在桶的中点
+    uint64_t percentile(double p) const;
+    // 合并另一个直方图，用于汇总各executor
+    void merge(const LatencyHistogram& other);
+    // 清零，和record并发时那次记录可能部分丢失，只用于按时间窗口统计
+    void reset();
+
+  private:
+    static constexpr int kSubBits = 4;
+    static constexpr int kSubCount = 1 << kSubBits;
+    static constexpr int kMaxExp = 47;  // 约39小时
+    static constexpr int kNumBuckets = (kMaxExp - kSubBits + 2) * kSubCount;
+
+    static int bucketIndex(uint64_t ns);
+    static uint64_t bucketMid(int index);
+
+    std::atomic<uint64_t> buckets_[kNumBuckets];
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// -----------------------------
+// Profiler 定义
+// 每个executor一组各阶段的直方图，session结束时输出JSON汇总或Chrome trace
+// 关闭时Session不创建Profiler，executor只多一次空指针判断
+// -----------------------------
+class Profiler {
+  public:
+    Profiler(const ProfilerCfg& cfg, int num_executor);
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 任务回调结束后调用，可以在executor线程或stream回调线程上
+    void record(int executor_id, const TaskTimes& times);
+    // 汇总日志并按cfg写文件
+    Result dump();
+
+    std::string toJson() const;
+    std::string toChromeTrace() const;
+
+  private:
+    struct ExecutorStats {
+        LatencyHistogram stages[STAGE_NUM];
+        std::mutex trace_lock;           // 只有chrome格式才会用到
+        std::vector<TaskTimes> traces;
+    };
+
+    void stageJson(std::string& out, const LatencyHistogram* stages, double seconds) const;
+
+    ProfilerCfg cfg_;
+    uint64_t start_ns_;
+    std::atomic<size_t> trace_count_{0};
+    std::vector<std::unique_ptr<ExecutorStats>> executors_;
+};
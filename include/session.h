@@ -5,29 +5,80 @@
 #include "tensor.h"
 #include "monitor.h"
 #include "task_queue.h"
+#include "deadline_queue.h"
 #include "util.h"
+#include "batcher.h"
+#include "placement.h"
+#include "preprocessor.h"
+#include "image_pipeline.h"
+#include "model_manager.h"
+#include "admission.h"
+#include "affinity.h"
+#include "autoscaler.h"
+#include "telemetry.h"
+#include "governor.h"
 #include <any>
+#include <future>
 
-using SessionOut = std::vector<std::vector<std::vector<uint8_t>>>;
+// 每个任务的全部输出张量，张量内存直接来自executor，不做拷贝
+using SessionOut = std::vector<std::vector<Tensor>>;
 
-using PreprocessFn = std::function<std::vector<uint8_t>(const std::any&)>;
 using PostprocessFn = std::function<void(const std::vector<Tensor>& outputs)>;
 
 struct TensorCfg {
     std::string name = "null";
     std::vector<uint32_t> shape;
     std::string dtype = "float32";
+    // 预处理产出的数据类型，与dtype不同时在提交前转换(如float32转float16/int8减少H2D拷贝量)，空表示相同
+    std::string host_dtype;
+    QuantParam quant;                // dtype或host_dtype为整数类型时的量化参数
 };
 
 
+// 单个请求的调度选项
+struct SubmitOptions {
+    std::string model;               // 为空时用model_path，否则executor按需切换到该模型
+    int priority = 0;                // 优先级通道，0最高，scheduler为edf时生效
+    uint32_t timeout_us = 0;         // 相对提交时刻的截止时间，0为不限；开始执行前已超时的请求被丢弃
+    DropCallback on_drop;            // 请求被丢弃(超时、模型加载失败)时调用，为空时回调收到空输出
+    int executor = -1;               // scheduler为steal时优先由该executor执行，-1为轮询分配
+};
+
 struct SessionCfg {
     std::string model_path;
     int num_executor;
     int num_task;
     std::string input_file;
-    std::vector<std::string> devices;
+    std::vector<DeviceCfg> devices;
+    PlacementPolicy device_policy = PLACE_ROUND_ROBIN;
     std::vector<TensorCfg> inputs;
     std::vector<TensorCfg> outputs;
+    int pipeline_depth = 1;          // 每个executor同时在途的任务数，1为同步执行
+    DummyLatency dummy_latency;      // 只对dummy后端生效
+    size_t dummy_batch_size = 1;     // 只对dummy后端生效
+    size_t cpu_threads = 0;          // 只对cpu后端生效，0为硬件线程数
+    bool batching = false;           // 是否在TaskQueue前面合并请求
+    BatcherCfg batcher;
+    ProfilerCfg profiler;
+    PreprocessCfg preprocess;
+    bool image_pipeline = false;     // 配置了image_pipeline时使用内置的融合预处理
+    ImagePipelineCfg image;
+    bool model_manager = false;      // 同一设备上服务多个模型，按内存水位淘汰
+    ModelManagerCfg manager;
+    std::map<std::string, DummyModelCost> dummy_models;  // 只对dummy后端生效，key为空表示默认值
+    std::map<int, std::vector<DummyTelemetryPoint>> dummy_telemetry;  // key为dummy设备id，测试限流用
+    SchedulerCfg scheduler;
+    bool admission = false;          // 配置了admission时限制排队和在途的请求数
+    AdmissionCfg admit;
+    size_t max_outputs = 0;          // Run最多保留的输出数，超出的只做后处理后丢弃，0不限
+    AffinityCfg affinity;
+    bool autoscale = false;          // 配置了autoscale时num_executor只是初始值
+    AutoscaleCfg scale;
+    bool telemetry = false;          // 配置了telemetry时start启动采样线程并注册session的指标
+    TelemetryCfg metrics;
+    bool governor = false;           // 配置了governor时按设备温度和显存限制每个设备的在途任务
+    GovernorCfg govern;
+    std::string error;               // loadConfig发现的配置错误，非空时start失败
 };
 
 
@@ -36,26 +87,91 @@ class Session {
   public:
     Session() = default;
     Session(const std::string& yaml_file);
-    ~Session() = default;
+    ~Session() { stop(); }
 
+    // 批处理接口：预处理num_task份input_file，全部跑完后返回
     SessionOut Run();
 
+    // 流式接口：start后executor线程常驻，可以持续submit，直到stop
+    Result start();
+    // 请求被丢弃、输入不合法或被准入控制拒绝时future得到空输出
+    std::future<std::vector<Tensor>> submit(std::vector<Tensor> inputs, const SubmitOptions& opts = {});
+    // 回调在executor或stream回调线程上执行；返回false表示输入张量个数或大小和配置不符，
+    // 或被准入控制拒绝(或等待超时)，回调不会被调用
+    bool submit(std::vector<Tensor> inputs, TaskCallback cb, const SubmitOptions& opts = {});
+    // 先经过预处理阶段再提交，需要先registerPreprocess；返回false表示被丢弃
+    bool submitRaw(std::any arg, TaskCallback cb);
+    // 等待所有已提交的任务完成
+    void drain();
+    // drain之后关闭任务队列并回收executor线程
+    void stop();
+
+    // 需要在start之前注册
     void registerPreprocess(PreprocessFn fn) { preprocess_fn_ = std::move(fn); }
+    bool hasPreprocess() const { return preprocess_fn_ != nullptr; }
     void registerPostprocess(PostprocessFn fn) { postprocess_fn_ = std::move(fn); }
 
   private:
     SessionCfg loadConfig(const std::string& yaml_file);
+    void taskDone();
+    // 按配置的inputs检查张量个数和大小，不合法的请求在入队前拒绝
+    bool checkInputs(const std::vector<Tensor>& inputs, const SubmitOptions& opts) const;
+    // 已经拿到准入名额之后构造Task并入队
+    void enqueue(std::vector<Tensor> inputs, TaskCallback cb, const SubmitOptions& opts);
+
+    // executor增删，调用方持有scale_lock_(scaleUp/scaleDown除外，它们由autoscaler线程调用)
+    ThreadPlacement planExecutor(int id, Backend* backend);
+    void addExecutor(int id, Backend* backend, const ThreadPlacement& plan);
+    int liveExecutors();
+    bool scaleUp();
+    bool scaleDown();
+    // 注册session级指标并启动Telemetry采样
+    void startTelemetry();
+    // 按配置的唯一一个输入的shape和dtype生成输入张量
+    std::vector<Tensor> makeInputs(std::vector<uint8_t>&& bytes) const;
+
     int num_executor_;
     int num_task_;
     
     Monitor* monitor_;
 
-    std::vector<std::unique_ptr<Executor>> executors_;
+    // executor和它的线程，缩容后退出的在下次扩容或stop时回收
+    struct ExecutorThread {
+        std::unique_ptr<Executor> executor;
+        std::thread thread;
+        std::atomic<bool> exited{false};
+    };
+    std::vector<std::unique_ptr<ExecutorThread>> executors_;  // 受scale_lock_保护
+    std::mutex scale_lock_;
+    std::atomic<int> retiring_{0};   // 已经发出退出任务、还没退出的executor数
+    uint64_t exited_busy_ns_{0};     // 已回收的executor的忙碌时间，受scale_lock_保护，autoscaler按累计值求差
+    std::unique_ptr<ThreadPlacer> exec_placer_;
+    std::unique_ptr<Autoscaler> autoscaler_;  // 未开启autoscale时为空
+    std::unique_ptr<Governor> governor_;      // 未开启governor时为空
+    int collector_id_{-1};
+    bool own_telemetry_{false};      // 采样线程由本session启动，stop时一起停掉
     std::unique_ptr<TaskQueue> tq_;
+    std::unique_ptr<Batcher> batcher_;
+    std::unique_ptr<Profiler> profiler_;  // 未开启时为空
+    std::unique_ptr<Preprocessor> preprocessor_;
+    std::unique_ptr<ImagePipeline> image_pipeline_;
+    std::unique_ptr<AdmissionControl> admission_;  // 未配置admission时为空
     std::string model_path_;
     std::vector<Backend*> backends_;
+    std::vector<float> weights_;     // 与backends_一一对应
+    std::vector<int> numa_nodes_;    // 与backends_一一对应，-1为未配置
+    ModelHandle model_;              // 只有开启batching时持有，用来读取batch大小
+    std::map<Backend*, std::unique_ptr<ModelManager>> managers_;  // 开启model_manager时每个设备一个
     std::vector<std::vector<Tensor>> outputs_;
-    std::atomic<int> task_counter_{0};
+    std::mutex outputs_lock_;        // 回调可能在多个executor或stream回调线程上并发执行
+    size_t batch_size_{1};
+    std::vector<size_t> input_bytes_;   // 每个输入张量单个样本的字节数，start时按配置计算
+
+    std::mutex state_lock_;          // 保护start/stop
+    bool running_{false};
+    std::atomic<int64_t> inflight_{0};
+    std::mutex drain_lock_;
+    std::condition_variable drain_cond_;
     SessionCfg scfg_;
     PreprocessFn preprocess_fn_;
     PostprocessFn postprocess_fn_;
@@ -1,31 +1,202 @@
 #pragma once
 
 #include "common.h"
+#include "mpmc_queue.h"
+#include "profiler.h"
 
-class Tensor;
+#include "tensor.h"
+
+using TaskCallback = std::function<void(std::vector<Tensor>&&)>;
+
+// 任务没有正常执行完时的原因
+enum TaskStatus {
+    TASK_OK,
+    TASK_EXPIRED,   // 开始执行前已经超过deadline，没有占用设备
+    TASK_FAILED,    // 模型加载失败等
+    TASK_REJECTED,  // 请求数达到上限，没有进入队列
+};
+
+inline const char* taskStatusName(TaskStatus status) {
+    switch (status) {
+        case TASK_OK: return "ok";
+        case TASK_EXPIRED: return "expired";
+        case TASK_FAILED: return "failed";
+        case TASK_REJECTED: return "rejected";
+        default: return "unknown";
+    }
+}
+
+using DropCallback = std::function<void(TaskStatus)>;
 
 // -----------------------------
 // Task 定义
 // -----------------------------
 struct Task {
     std::vector<Tensor> inputs;                        // 输入张量
-    std::function<void(std::vector<Tensor>&&)> cb;      // 回调函数（输出）
+    TaskCallback cb;                                    // 回调函数（输出）
+    TaskTimes times;                                    // 只在开启profiler时记录
+    std::string model;                                  // 为空时用session的model_path
+    int priority{0};                                    // 优先级通道，0最高
+    uint64_t deadline{0};                               // 绝对截止时间，Profiler::now()的ns，0为不限
+    DropCallback on_drop;                               // 为空时丢弃任务以空输出调用cb
+    int shard{-1};                                      // 分片队列中指定的executor，-1为轮询
+    bool retire{false};                                 // 缩容用的空任务，取到的executor处理完在途任务后退出
 
     Task() = default;
     ~Task() = default;
 
     Task(std::vector<Tensor> in,
-         std::function<void(std::vector<Tensor>&&)> callback)
+         TaskCallback callback)
         : inputs(std::move(in)), cb(std::move(callback)) {}
+
+    bool expired(uint64_t now) const { return deadline != 0 && now > deadline; }
+
+    // 不执行，直接以status结束任务
+    void drop(TaskStatus status) {
+        if (on_drop) {
+            on_drop(status);
+        } else if (cb) {
+            cb({});
+        }
+    }
 };
 
 // -----------------------------
-// TaskQueue 定义
+// TaskQueue 接口
+// executor从这里取任务，shutdown后pop把剩余任务取完再返回false
 // -----------------------------
 class TaskQueue {
 public:
-    TaskQueue() = default;
-    ~TaskQueue() = default;
+    virtual ~TaskQueue() = default;
+    virtual void push(Task task) = 0;
+    virtual bool pop(Task& task_out) = 0;
+    // worker为调用方executor的编号，按executor分片的队列用它找本地队列
+    virtual bool pop(Task& task_out, int worker) { return pop(task_out); }
+    virtual void shutdown() = 0;
+    virtual size_t size() const = 0;
+};
+
+// -----------------------------
+// FifoTaskQueue 定义
+// 基于无锁环形队列，push/pop先自旋，再让出CPU，最后才挂起等待
+// 容量有界，队列满时push会阻塞直到有空位
+// -----------------------------
+class FifoTaskQueue : public TaskQueue {
+public:
+    explicit FifoTaskQueue(size_t capacity = 4096) : queue_(capacity) {}
+    ~FifoTaskQueue() = default;
+
+    void push(Task task) override {
+        if (!queue_.tryPush(task)) {
+            waitFor([&] { return queue_.tryPush(task); },
+                    [this] { return queue_.size() < queue_.capacity(); },
+                    not_full_, idle_producers_);
+        }
+        wake(not_empty_, idle_consumers_);
+    }
+
+    bool pop(Task& task_out) override {
+        auto got = queue_.tryPop(task_out) ||
+                   waitFor([&] { return queue_.tryPop(task_out); },
+                           [this] { return stop_.load(std::memory_order_acquire) || queue_.size() > 0; },
+                           not_empty_, idle_consumers_,
+                           [this] { return stop_.load(std::memory_order_acquire); });
+        if (!got) {
+            // 停止后还要把剩下的任务取完
+            got = queue_.tryPop(task_out);
+        }
+        if (!got) {
+            INFO_LOG("Task Queue stopped! and the queue's size = %ld", queue_.size());
+            return false;
+        }
+        wake(not_full_, idle_producers_);
+        return true;
+    }
+
+    void shutdown() override {
+        stop_.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(park_lock_);
+        not_empty_.notify_all(); // 唤醒所有等待线程
+        not_full_.notify_all();
+    }
+
+    size_t size() const override {
+        return queue_.size();
+    }
+
+private:
+    static constexpr int kMinSpin = 16;
+    static constexpr int kMaxSpin = 1024;
+    static constexpr int kYieldRounds = 8;
+
+    // try_fn成功返回true；abort_fn为真时放弃等待返回false
+    template <typename TryFn, typename ReadyFn, typename AbortFn = bool (*)()>
+    bool waitFor(TryFn try_fn, ReadyFn ready_fn, std::condition_variable& cond, std::atomic<int>& idle,
+                 AbortFn abort_fn = [] { return false; }) {
+        while (true) {
+            // 自旋，上限根据最近自旋是否成功自适应调整
+            int limit = spin_limit_.load(std::memory_order_relaxed);
+            for (int i = 0; i < limit; i++) {
+                if (try_fn()) {
+                    if (limit < kMaxSpin) {
+                        spin_limit_.store(std::min(kMaxSpin, limit * 2), std::memory_order_relaxed);
+                    }
+                    return true;
+                }
+                if (abort_fn()) {
+                    return false;
+                }
+                cpuRelax();
+            }
+            for (int i = 0; i < kYieldRounds; i++) {
+                std::this_thread::yield();
+                if (try_fn()) {
+                    return true;
+                }
+                if (abort_fn()) {
+                    return false;
+                }
+            }
+            if (limit > kMinSpin) {
+                spin_limit_.store(std::max(kMinSpin, limit / 2), std::memory_order_relaxed);
+            }
+
+            // 挂起，idle计数和队列状态之间用seq_cst栅栏保证唤醒不丢失
+            std::unique_lock<std::mutex> lock(park_lock_);
+            idle.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cond.wait(lock, ready_fn);
+            idle.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void wake(std::condition_variable& cond, std::atomic<int>& idle) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(park_lock_);
+            cond.notify_one();
+        }
+    }
+
+    MPMCQueue<Task> queue_;
+    std::atomic<bool> stop_{false};
+    std::atomic<int> spin_limit_{128};
+
+    std::mutex park_lock_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::atomic<int> idle_consumers_{0};
+    std::atomic<int> idle_producers_{0};
+};
+
+// -----------------------------
+// LockedTaskQueue 定义
+// 原先的互斥锁+条件变量实现，保留作为基准测试的对照
+// -----------------------------
+class LockedTaskQueue {
+public:
+    LockedTaskQueue() = default;
+    ~LockedTaskQueue() = default;
     
     void push(Task task) {
         {
@@ -40,9 +211,6 @@ public:
         cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
 
         if (stop_ && queue_.empty()) {
-            if (stop_) {
-                INFO_LOG("Task Queue stopped! and the queue's size = %ld", queue_.size());
-            }
             return false;
         }
 
@@ -68,5 +236,5 @@ private:
     mutable std::mutex mutex_;
     std::condition_variable cond_;
     std::queue<Task> queue_;
-    bool stop_;
+    bool stop_{false};
 };
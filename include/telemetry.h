@@ -0,0 +1,130 @@
+#pragma once
+
+#include "common.h"
+#include <map>
+
+struct TelemetryCfg {
+    uint32_t interval_ms = 1000;     // 采样周期
+    size_t history = 600;            // 每条时间序列保留的采样点数
+    std::string prometheus_file;     // 非空时每次采样后覆盖写Prometheus文本格式
+    int http_port = 0;               // 非0时在127.0.0.1上提供 GET /metrics
+};
+
+enum MetricType {
+    METRIC_GAUGE,
+    METRIC_COUNTER,                  // 单调递增，采样值为累计值
+};
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+struct MetricSample {
+    uint64_t ts;                     // Profiler::now()的ns
+    double value;
+};
+
+// -----------------------------
+// TimeSeries 定义
+// 固定容量的环形缓冲，满了覆盖最老的点，不加锁，由Telemetry保护
+// -----------------------------
+class TimeSeries {
+  public:
+    explicit TimeSeries(size_t capacity) : samples_(std::max<size_t>(1, capacity)) {}
+
+    void push(uint64_t ts, double value) {
+        samples_[head_] = {ts, value};
+        head_ = (head_ + 1) % samples_.size();
+        size_ = std::min(size_ + 1, samples_.size());
+    }
+    size_t size() const { return size_; }
+    // 最新的点，size为0时未定义
+    const MetricSample& last() const { return samples_[(head_ + samples_.size() - 1) % samples_.size()]; }
+    // 按时间从旧到新
+    std::vector<MetricSample> samples() const;
+
+  private:
+    std::vector<MetricSample> samples_;
+    size_t head_{0};
+    size_t size_{0};
+};
+
+struct SeriesSnapshot {
+    std::string name;
+    MetricLabels labels;
+    MetricType type;
+    std::vector<MetricSample> samples;
+};
+
+// -----------------------------
+// Telemetry 定义
+// 进程内唯一的采样器：各模块注册collector，采样线程每interval_ms调用一遍，
+// collector通过emit写入指标，每个(指标名, 标签)一条TimeSeries；
+// 可以拿快照，也可以导出Prometheus文本格式(写文件或本地HTTP)
+// -----------------------------
+class Telemetry {
+  public:
+    using Emit = std::function<void(const std::string& name, const MetricLabels& labels, double value)>;
+    using Collector = std::function<void(const Emit& emit)>;
+
+    static Telemetry* getInstance() {
+        static Telemetry telemetry;
+        return &telemetry;
+    }
+
+    // 指标的类型和说明，没有描述的指标按gauge导出
+    void describe(const std::string& name, MetricType type, const std::string& help);
+    // 返回id，removeCollector返回后collector不会再被调用，它写过的序列也一起删掉
+    int addCollector(Collector collector);
+    void removeCollector(int id);
+
+    // 已经在运行时只更新配置中的导出方式
+    Result start(const TelemetryCfg& cfg);
+    // 停止前把最后的值写一次文件
+    void stop();
+    bool running() const;
+    // 立即采样一次，采样线程也调用它
+    void sampleOnce();
+
+    // name为空时返回全部序列
+    std::vector<SeriesSnapshot> snapshot(const std::string& name = "") const;
+    // 每条序列的最新值
+    std::string toPrometheus() const;
+
+  private:
+    Telemetry() = default;
+    ~Telemetry();
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    struct Series {
+        std::string name;
+        MetricLabels labels;
+        int owner;
+        TimeSeries data;
+    };
+    struct Meta {
+        MetricType type;
+        std::string help;
+    };
+
+    void loop();
+    void serveHttp();
+    void writeFile() const;
+    static std::string seriesKey(const std::string& name, const MetricLabels& labels);
+
+    TelemetryCfg cfg_;
+
+    std::mutex collect_lock_;        // 采样期间持有，removeCollector等当前这一轮结束
+    std::map<int, Collector> collectors_;
+    int next_id_{0};
+
+    mutable std::mutex lock_;        // 保护series_和meta_
+    std::map<std::string, Series> series_;  // key为名字加标签，导出时同名指标相邻
+    std::map<std::string, Meta> meta_;
+
+    mutable std::mutex state_lock_;
+    std::condition_variable cond_;
+    bool stop_{true};
+    std::thread sampler_;
+    std::thread http_;
+    int listen_fd_{-1};
+};
@@ -1,36 +1,83 @@
 #pragma once
 
+#include "common.h"
+#include "convert.h"
 
+// 张量只是对一块内存的引用：拷贝Tensor共享同一块内存(引用计数)，不会复制数据
+// 内存可以是自己分配的、接管的vector、带自定义释放函数的外部内存(如后端锁页内存、mmap)，
+// 也可以是完全不持有的视图
 class Tensor {
 public:
+    using Deleter = std::function<void(void*)>;
+
+    // 分配未初始化的内存
     Tensor(const std::vector<uint32_t>& shape, DataType dtype)
         : shape_(shape), datatype_(dtype) {
-          size_t num_elements = std::accumulate(
-          shape.begin(), shape.end(), 1u, std::multiplies<uint32_t>()
-          );
-          size_ = num_elements * getElementSize(dtype);
-          data_.resize(size_);
+          size_ = elementCount() * getElementSize(dtype);
+          auto buffer = std::shared_ptr<uint8_t[]>(new uint8_t[size_]);
+          data_ = buffer.get();
+          holder_ = std::move(buffer);
         }
 
+    // 接管vector，长度不符时按shape截断或补零
     Tensor(std::vector<uint8_t> data, const std::vector<uint32_t>& shape, DataType dtype)
-        : Tensor(shape, dtype) {
-          data_ = std::move(data);
-          if (data_.size() != size_) {
+        : shape_(shape), datatype_(dtype) {
+          size_ = elementCount() * getElementSize(dtype);
+          if (data.size() != size_) {
             data.resize(size_);
           }
+          auto buffer = std::make_shared<std::vector<uint8_t>>(std::move(data));
+          data_ = buffer->data();
+          holder_ = std::move(buffer);
+        }
+
+    // 外部内存，最后一个引用释放时调用deleter；deleter为空表示不接管，释放时什么也不做
+    Tensor(void* data, const std::vector<uint32_t>& shape, DataType dtype, Deleter deleter)
+        : shape_(shape), datatype_(dtype) {
+          size_ = elementCount() * getElementSize(dtype);
+          data_ = static_cast<uint8_t*>(data);
+          // 空的std::function被调用会在释放张量的线程上抛bad_function_call
+          if (!deleter) {
+            deleter = [](void*) {};
+          }
+          holder_ = std::shared_ptr<void>(data, std::move(deleter));
         }
 
+    // 不持有内存的视图，调用方保证data的生命周期
+    static Tensor view(void* data, const std::vector<uint32_t>& shape, DataType dtype) {
+      return Tensor(data, shape, dtype, nullptr, {});
+    }
 
-    // Tensor(const Tensor&) = delete;
-    // Tensor& operator=(const Tensor&) = delete;
+    Tensor(const Tensor&) = default;
+    Tensor& operator=(const Tensor&) = default;
+    Tensor(Tensor&&) = default;
+    Tensor& operator=(Tensor&&) = default;
 
     ~Tensor() = default;
 
-    void* data() { return data_.data(); }
+    void* data() { return data_; }
+    const void* data() const { return data_; }
     // tensor的字节长度
     const size_t size() const { return size_; }
     const std::vector<uint32_t>& shape() const { return shape_; }
     DataType dataType() const { return datatype_; }
+    // 视图不持有内存
+    bool isView() const { return holder_ == nullptr; }
+    long useCount() const { return holder_.use_count(); }
+
+    // 从offset字节开始取一段，与原张量共享内存
+    Tensor slice(size_t offset, const std::vector<uint32_t>& shape) const {
+      Tensor t(data_ + offset, shape, datatype_, nullptr, holder_);
+      assert(offset + t.size_ <= size_);
+      return t;
+    }
+
+    // 深拷贝
+    Tensor clone() const {
+      Tensor t(shape_, datatype_);
+      std::memcpy(t.data_, data_, size_);
+      return t;
+    }
 
     inline size_t getElementSize(DataType dtype) const {
       switch (dtype) {
@@ -38,35 +85,45 @@ public:
         case DataType::INT8:   return 1;
         case DataType::FLOAT16: return 2;
         case DataType::UINT8: return 1;
+        case DataType::BFLOAT16: return 2;
         default: assert(0);
       }
     }
 
     template<typename T>
     T* as() {
-      return reinterpret_cast<T*>(data_.data());
+      return reinterpret_cast<T*>(data_);
     }
 
     template<typename T>
     const T* as() const {
-      return reinterpret_cast<const T*>(data_.data());
+      return reinterpret_cast<const T*>(data_);
     }
 
-    // template<typename T>
-    // std::vector<T> asVector() const {
-    //   assert(getElementSize(dataType()) == sizeof(T));
-    //   size_t count = size_ / sizeof(T);
-    //   const T* ptr = reinterpret_cast<const T*>(data_.data());
-    //   return std::vector<T>(ptr, ptr + count);
-    // }
-    
+    // 转换为另一种数据类型，得到新分配的张量；类型相同时直接共享内存
+    // 整数类型用q做量化参数，实现在convert.cc
+    Tensor convertTo(DataType dtype, QuantParam q = {}) const;
+
+    // 会拷贝数据，热路径上用as<T>()或data()
     std::vector<uint8_t> asVector() const {
-        return data_;
+        return std::vector<uint8_t>(data_, data_ + size_);
     }
 
 
 private:
-    std::vector<uint8_t> data_;
+    Tensor(void* data, const std::vector<uint32_t>& shape, DataType dtype, std::nullptr_t,
+           std::shared_ptr<void> holder)
+        : holder_(std::move(holder)), shape_(shape), datatype_(dtype) {
+          size_ = elementCount() * getElementSize(dtype);
+          data_ = static_cast<uint8_t*>(data);
+        }
+
+    size_t elementCount() const {
+      return std::accumulate(shape_.begin(), shape_.end(), (size_t)1, std::multiplies<size_t>());
+    }
+
+    std::shared_ptr<void> holder_;  // 为空表示视图
+    uint8_t* data_{nullptr};
     size_t size_{};
     std::vector<uint32_t> shape_;
     DataType datatype_;
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common.h"
+#include <deque>
+
+// -----------------------------
+// ThreadPool 定义
+// 给算子做intra-op并行，多个executor可以同时往同一个池子提交parallelFor
+// 调用线程也会参与计算，池子忙时退化为调用线程自己算完
+// -----------------------------
+class ThreadPool {
+  public:
+    using RangeFn = std::function<void(size_t, size_t)>;
+
+    explicit ThreadPool(size_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 工作线程数，不含调用线程
+    size_t size() const { return workers_.size(); }
+    // 把[begin, end)按grain切块，fn(lo, hi)处理一块，全部完成后返回
+    void parallelFor(size_t begin, size_t end, size_t grain, const RangeFn& fn);
+
+  private:
+    struct Job {
+        const RangeFn* fn;
+        size_t begin;
+        size_t end;
+        size_t grain;
+        size_t chunks;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex lock;
+        std::condition_variable cond;
+    };
+
+    void loop();
+    // 领一块执行，没有剩余块时返回false
+    static bool runChunk(Job& job);
+
+    std::mutex lock_;
+    std::condition_variable cond_;
+    std::deque<std::shared_ptr<Job>> jobs_;
+    bool stop_{false};
+    std::vector<std::thread> workers_;
+};
@@ -1,9 +1,16 @@
 #pragma once
 #include "common.h"
+#include "tensor.h"
 
 DataType stringToDataType(const std::string& str);
+// 不认识的名字返回false，用于校验配置文件，stringToDataType遇到未知名字直接assert
+bool isDataTypeName(const std::string& str);
 std::vector<uint16_t> bytesToUint16(const std::vector<uint8_t>& bytes);
 std::vector<float> bytesToFloat32(const std::vector<uint8_t>& bytes);
+std::vector<uint16_t> bytesToUint16(const Tensor& tensor);
+std::vector<float> bytesToFloat32(const Tensor& tensor);
+// 按张量的dtype解码为float32，整数类型用q反量化
+std::vector<float> tensorToFloat32(const Tensor& tensor, QuantParam q = {});
 std::vector<int> top5Indices(const std::vector<float>& res);
 
 template <typename T>
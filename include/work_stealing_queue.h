@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common.h"
+#include "task_queue.h"
+
+// -----------------------------
+// WorkStealingQueue 定义
+// 每个executor一个本地无锁环形队列，push轮询分片(或按Task::shard指定)，pop先取本地队列，
+// 空了再从随机选的其他队列偷最老的任务；executor平时只访问自己的队列，
+// executor数增加时不再集中在一个队列的位置计数器上，见bench/work_stealing_bench
+// 不区分优先级和deadline，超时的任务由executor丢弃
+// -----------------------------
+class WorkStealingQueue : public TaskQueue {
+  public:
+    // capacity为所有分片合计，每个分片向上取整到2的幂
+    WorkStealingQueue(int num_workers, size_t capacity = 4096);
+    ~WorkStealingQueue() = default;
+
+    void push(Task task) override;
+    // 不知道调用方是哪个executor时当作0号
+    bool pop(Task& task_out) override { return pop(task_out, 0); }
+    bool pop(Task& task_out, int worker) override;
+    void shutdown() override;
+    size_t size() const override;
+
+    uint64_t stealCount() const { return steals_.load(std::memory_order_relaxed); }
+
+  private:
+    static constexpr int kRetryRounds = 8;
+
+    bool tryPush(Task& task, size_t first);
+    // 从其他分片偷一个最老的任务
+    bool steal(size_t worker, Task& task_out);
+    void wake(std::condition_variable& cond, std::atomic<int>& idle);
+
+    std::vector<std::unique_ptr<MPMCQueue<Task>>> shards_;
+    std::atomic<uint64_t> next_{0};    // 轮询分片
+    std::atomic<uint64_t> steals_{0};
+    std::atomic<bool> stop_{false};
+
+    std::mutex park_lock_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::atomic<int> idle_consumers_{0};
+    std::atomic<int> idle_producers_{0};
+};
@@ -35,8 +35,8 @@ int main() {
     auto outputs = s2.Run();
     for (int i = 0; i < outputs.size(); i++) {
         printf("task[%d]'s output:\n", i);
-        for (auto task_out : outputs[i]) {
-            printVector(bytesToUint16(task_out));
+        for (auto& task_out : outputs[i]) {
+            printVector(tensorToFloat32(task_out));
         }
     }
 }
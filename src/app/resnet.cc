@@ -64,11 +64,14 @@ std::vector<uint8_t> resnetPreprocess(const std::any& arg) {
 int main() {
     std::string yaml = "../resnet.yaml";
     Session s2(yaml);
-    s2.registerPreprocess(resnetPreprocess);
+    // yaml中配置了image_pipeline时使用内置的融合预处理
+    if (!s2.hasPreprocess()) {
+        s2.registerPreprocess(resnetPreprocess);
+    }
     auto outputs = s2.Run();
     for (int i = 0; i < outputs.size(); i++) {
         printf("task[%d]'s output:\n", i);
-        for (auto task_out : outputs[i]) {
+        for (auto& task_out : outputs[i]) {
             printVector(top5Indices(bytesToFloat32(task_out)));
         }
     }
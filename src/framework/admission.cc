@@ -0,0 +1,66 @@
+#include "admission.h"
+
+OverflowPolicy stringToOverflowPolicy(const std::string& str) {
+    if (str == "block") return OVERFLOW_BLOCK;
+    else if (str == "timeout") return OVERFLOW_TIMEOUT;
+    else if (str == "reject") return OVERFLOW_REJECT;
+    else {
+        WARN_LOG("unknown overflow policy %s, use block", str.c_str());
+        return OVERFLOW_BLOCK;
+    }
+}
+
+AdmissionControl::AdmissionControl(const AdmissionCfg& cfg, std::function<size_t()> queued)
+    : cfg_(cfg), queued_(std::move(queued)) {
+    static const char* names[] = {"block", "timeout", "reject"};
+    INFO_LOG("Admission: max inflight %zu, max queued %zu, %s when full", cfg_.max_inflight, cfg_.max_queued,
+             names[cfg_.overflow]);
+}
+
+bool AdmissionControl::hasRoom() const {
+    if (cfg_.max_inflight > 0 && inflight_ >= cfg_.max_inflight) {
+        return false;
+    }
+    return cfg_.max_queued == 0 || queued_() < cfg_.max_queued;
+}
+
+bool AdmissionControl::acquire(bool must_wait) {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (!hasRoom()) {
+        // 排队的任务被executor取走后一定会完成并release，所以只需在release时唤醒
+        if (must_wait || cfg_.overflow == OVERFLOW_BLOCK) {
+            cond_.wait(lock, [this] { return hasRoom(); });
+        } else if (cfg_.overflow == OVERFLOW_REJECT) {
+            rejected_++;
+            return false;
+        } else if (!cond_.wait_for(lock, std::chrono::milliseconds(cfg_.timeout_ms), [this] { return hasRoom(); })) {
+            timed_out_++;
+            return false;
+        }
+        waited_++;
+    }
+    inflight_++;
+    admitted_++;
+    peak_inflight_ = std::max(peak_inflight_, inflight_);
+    return true;
+}
+
+void AdmissionControl::release() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        assert(inflight_ > 0);
+        inflight_--;
+    }
+    cond_.notify_one();
+}
+
+size_t AdmissionControl::inflight() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return inflight_;
+}
+
+void AdmissionControl::logStats() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    INFO_LOG("Admission: admitted %lu (waited %lu), rejected %lu, timed out %lu, peak inflight %zu",
+             admitted_, waited_, rejected_, timed_out_, peak_inflight_);
+}
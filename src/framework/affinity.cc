@@ -0,0 +1,219 @@
+#include "affinity.h"
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+constexpr int kMpolPreferred = 1;    // numaif.h中的MPOL_PREFERRED，不依赖libnuma
+#endif
+
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &set)) {
+                cpus.push_back(i);
+            }
+        }
+        return cpus;
+    }
+#endif
+    for (int i = 0; i < (int)std::max(1u, std::thread::hardware_concurrency()); i++) {
+        cpus.push_back(i);
+    }
+    return cpus;
+}
+
+}  // namespace
+
+const CpuTopology& CpuTopology::get() {
+    static CpuTopology topology;
+    return topology;
+}
+
+CpuTopology::CpuTopology() {
+    all_cpus_ = allowedCpus();
+    std::unordered_map<int, bool> allowed;
+    for (int cpu : all_cpus_) {
+        allowed[cpu] = true;
+    }
+    for (int node = 0;; node++) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file) {
+            break;
+        }
+        std::string line;
+        std::getline(file, line);
+        std::vector<int> cpus;
+        for (int cpu : parseCpuList(line)) {
+            if (allowed.count(cpu)) {
+                cpus.push_back(cpu);
+                cpu_node_[cpu] = node;
+            }
+        }
+        node_cpus_.push_back(std::move(cpus));
+    }
+    if (node_cpus_.empty()) {
+        node_cpus_.push_back(all_cpus_);
+        for (int cpu : all_cpus_) {
+            cpu_node_[cpu] = 0;
+        }
+    }
+}
+
+int CpuTopology::nodeOf(int cpu) const {
+    auto it = cpu_node_.find(cpu);
+    return it == cpu_node_.end() ? -1 : it->second;
+}
+
+std::vector<int> CpuTopology::parseCpuList(const std::string& str) {
+    std::vector<int> cpus;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        // 允许"0, 2"这样带空白的写法
+        auto begin = item.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos) {
+            continue;
+        }
+        item = item.substr(begin, item.find_last_not_of(" \t\r\n") - begin + 1);
+        // 单个数和区间都要求整项被完整解析，"3x"、"3-"不能当成3
+        int lo = 0, hi = 0;
+        char tail = 0;
+        bool range = item.find('-') != std::string::npos;
+        bool ok = range ? sscanf(item.c_str(), "%d-%d%c", &lo, &hi, &tail) == 2
+                        : sscanf(item.c_str(), "%d%c", &lo, &tail) == 1;
+        if (!range) {
+            hi = lo;
+        }
+        if (!ok || lo < 0 || hi < lo) {
+            WARN_LOG("Affinity: invalid cpu list item \"%s\" in \"%s\"", item.c_str(), str.c_str());
+            return {};
+        }
+        for (int cpu = lo; cpu <= hi; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::string CpuTopology::formatCpuList(const std::vector<int>& cpus) {
+    std::string out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        out += (out.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (j > i) {
+            out += "-" + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return out;
+}
+
+ThreadPlacer::ThreadPlacer(const std::string& prefix, const std::string& cpus, const AffinityCfg& cfg)
+    : prefix_(prefix), cfg_(cfg) {
+    auto& topo = CpuTopology::get();
+    if (cpus == "numa") {
+        by_node_ = true;
+        return;
+    }
+    for (int cpu : CpuTopology::parseCpuList(cpus)) {
+        if (topo.nodeOf(cpu) < 0) {
+            WARN_LOG("Affinity: cpu %d of %s threads is not available, skipped", cpu, prefix_.c_str());
+            continue;
+        }
+        cpus_.push_back(cpu);
+    }
+    if (!cpus.empty() && cpus_.empty()) {
+        WARN_LOG("Affinity: no usable cpu in \"%s\", %s threads are not pinned", cpus.c_str(), prefix_.c_str());
+    }
+}
+
+ThreadPlacement ThreadPlacer::plan(int index, int node) {
+    auto& topo = CpuTopology::get();
+    ThreadPlacement p;
+    p.name = prefix_ + "-" + std::to_string(index);
+    std::vector<int> pool = cpus_;
+    int slot = index;
+    if (by_node_) {
+        // 没有设备的线程按编号轮流分到各节点
+        if (node < 0 || node >= topo.numNodes()) {
+            node = index % topo.numNodes();
+        }
+        pool = topo.cpusOf(node);
+        slot = next_in_node_[node]++;
+    }
+    if (pool.empty()) {
+        return p;
+    }
+    if (cfg_.per_core) {
+        p.cpus = {pool[slot % pool.size()]};
+    } else {
+        p.cpus = pool;
+    }
+    if (cfg_.numa_memory) {
+        // 核跨多个节点时按第一个核所在节点
+        p.node = topo.nodeOf(p.cpus[0]);
+    }
+    return p;
+}
+
+void ThreadPlacer::apply(const ThreadPlacement& placement) {
+    setThreadName(placement.name);
+#ifdef __linux__
+    if (!placement.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : placement.cpus) {
+            CPU_SET(cpu, &set);
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            WARN_LOG("Affinity: pin %s to cpus %s failed: %s", placement.name.c_str(),
+                     CpuTopology::formatCpuList(placement.cpus).c_str(), strerror(err));
+        }
+    }
+    if (placement.node >= 0 && CpuTopology::get().numNodes() > 1) {
+        // 只影响本线程之后的分配，首次写入时才真正落到物理页
+        unsigned long mask[16] = {0};
+        mask[placement.node / 64] |= 1UL << (placement.node % 64);
+        if (syscall(SYS_set_mempolicy, kMpolPreferred, mask, sizeof(mask) * 8) != 0) {
+            WARN_LOG("Affinity: bind %s memory to node %d failed: %s", placement.name.c_str(), placement.node,
+                     strerror(errno));
+        }
+    }
+#else
+    if (!placement.cpus.empty()) {
+        WARN_LOG("Affinity: cpu pinning is only supported on linux");
+    }
+#endif
+}
+
+void ThreadPlacer::logPlan(const std::vector<ThreadPlacement>& plans) {
+    for (auto& p : plans) {
+        if (p.cpus.empty()) {
+            continue;
+        }
+        INFO_LOG("Affinity: %s -> cpus %s, memory node %d", p.name.c_str(),
+                 CpuTopology::formatCpuList(p.cpus).c_str(), p.node);
+    }
+}
+
+void setThreadName(const std::string& name) {
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#endif
+}
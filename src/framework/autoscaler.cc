@@ -0,0 +1,132 @@
+#include "autoscaler.h"
+#include "affinity.h"
+
+Autoscaler::Autoscaler(const AutoscaleCfg& cfg, Hooks hooks) : cfg_(cfg), hooks_(std::move(hooks)) {
+    cfg_.min_executors = std::max(1, cfg_.min_executors);
+    cfg_.max_executors = std::max(cfg_.min_executors, cfg_.max_executors);
+    cfg_.interval_ms = std::max<uint32_t>(1, cfg_.interval_ms);
+}
+
+Autoscaler::~Autoscaler() {
+    stop();
+}
+
+void Autoscaler::start() {
+    stop_ = false;
+    window_begin_ = Profiler::now();
+    last_busy_ns_ = hooks_.busy_ns();
+    worker_ = std::thread(&Autoscaler::loop, this);
+    INFO_LOG("Autoscaler started, executors %d~%d, every %u ms", cfg_.min_executors, cfg_.max_executors,
+             cfg_.interval_ms);
+}
+
+void Autoscaler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (stop_) {
+            return;
+        }
+        stop_ = true;
+    }
+    cond_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    INFO_LOG("Autoscaler stopped, scaled up %lu times, down %lu times", ups_, downs_);
+}
+
+void Autoscaler::record(uint64_t latency_ns) {
+    // 先登记再确认窗口没被切走，和tick里先切换再等writers_归零配对，保证tick读的窗口没有人在写
+    int cur;
+    while (true) {
+        cur = current_.load();
+        writers_[cur].fetch_add(1);
+        if (current_.load() == cur) {
+            break;
+        }
+        writers_[cur].fetch_sub(1);
+    }
+    windows_[cur].record(latency_ns);
+    writers_[cur].fetch_sub(1);
+}
+
+void Autoscaler::loop() {
+    setThreadName("autoscaler");
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!cond_.wait_for(lock, std::chrono::milliseconds(cfg_.interval_ms), [this] { return stop_; })) {
+        lock.unlock();
+        tick(Profiler::now());
+        lock.lock();
+    }
+}
+
+void Autoscaler::tick(uint64_t now) {
+    int old = current_.load();
+    current_.store(old ^ 1);
+    while (writers_[old].load() != 0) {
+        std::this_thread::yield();
+    }
+    auto& window = windows_[old];
+    double seconds = (now - window_begin_) / 1e9;
+    window_begin_ = now;
+    uint64_t busy = hooks_.busy_ns();
+    uint64_t busy_delta = busy > last_busy_ns_ ? busy - last_busy_ns_ : 0;
+    last_busy_ns_ = busy;
+
+    size_t depth = hooks_.queue_depth();
+    int live = std::max(1, hooks_.live());
+    uint64_t p99 = window.count() > 0 ? window.percentile(99) : 0;
+    double tput = seconds > 0 ? window.count() / seconds : 0.0;
+    // 端到端延迟含排队，流水线下多个任务还会重叠，用executor自己统计的忙碌时间算利用率，不超过1
+    double util = seconds > 0 ? busy_delta / 1e9 / seconds / live : 0.0;
+    window.reset();
+    DEBUG_LOG("Autoscaler: %d executors, queue %zu, p99 %.2f ms, utilization %.2f", live, depth, p99 / 1e6, util);
+
+    if (now - last_change_ < (uint64_t)cfg_.cooldown_ms * 1000000) {
+        return;
+    }
+    bool deep = depth > cfg_.queue_per_executor * live;
+    bool slow = cfg_.p99_ms > 0 && p99 > (uint64_t)cfg_.p99_ms * 1000000;
+    if ((deep || slow) && live < cfg_.max_executors && (knee_ == 0 || live < knee_)) {
+        idle_since_ = 0;
+        if (last_up_live_ > 0 && live > last_up_live_ && tput < last_up_tput_ * (1 + cfg_.min_gain)) {
+            knee_ = live - 1;
+            INFO_LOG("Autoscaler: %.0f tasks/s with %d executors vs %.0f with %d, device saturated, keep %d",
+                     tput, live, last_up_tput_, last_up_live_, knee_);
+            if (hooks_.scale_down()) {
+                downs_++;
+                last_change_ = now;
+            }
+            return;
+        }
+        if (hooks_.scale_up()) {
+            INFO_LOG("Autoscaler: scale up to %d executors (queue %zu, p99 %.2f ms, %.0f tasks/s)", live + 1, depth,
+                     p99 / 1e6, tput);
+            ups_++;
+            last_change_ = now;
+            last_up_live_ = live;
+            last_up_tput_ = tput;
+        }
+        return;
+    }
+
+    bool idle = depth == 0 && util < cfg_.low_utilization && !slow;
+    if (!idle) {
+        idle_since_ = 0;
+        return;
+    }
+    if (idle_since_ == 0) {
+        idle_since_ = now;
+    }
+    if (now - idle_since_ >= (uint64_t)cfg_.idle_ms * 1000000 && live > cfg_.min_executors) {
+        if (hooks_.scale_down()) {
+            INFO_LOG("Autoscaler: scale down to %d executors (utilization %.2f)", live - 1, util);
+            downs_++;
+            last_change_ = now;
+            // 负载变了，拐点重新探测
+            knee_ = 0;
+            last_up_live_ = 0;
+        }
+        idle_since_ = now;
+    }
+}
@@ -0,0 +1,326 @@
+#include "backend/cpu.h"
+#include "backend/dummy.h"
+#include "util.h"
+#include <fstream>
+#include <random>
+#include <yaml-cpp/yaml.h>
+
+Cpu::Cpu(int device_id)
+    : Backend(BAKCEND_CPU, device_id)
+    , num_threads_(std::max(1u, std::thread::hardware_concurrency())) {}
+
+Cpu::~Cpu() {
+    pool_->trim();
+    host_pool_->trim();
+}
+
+Result Cpu::init() {
+    if (thread_pool_ != nullptr) {
+        return SUCCESS;
+    }
+    // 调用线程也参与计算，所以少开一个
+    thread_pool_ = std::make_unique<ThreadPool>(num_threads_ - 1);
+    INFO_LOG("Cpu[%d] Init Success, %zu threads, simd = %s", device_id_, num_threads_, cpu::simdName());
+    return SUCCESS;
+}
+
+Result Cpu::finalize() {
+    pool_->trim();
+    host_pool_->trim();
+    thread_pool_.reset();
+    return SUCCESS;
+}
+
+Result Cpu::malloc(void **dev_ptr, uint64_t size) {
+    if (posix_memalign(dev_ptr, 64, size) != 0) {
+        ERROR_LOG("Cpu: 分配内存失败");
+        *dev_ptr = nullptr;
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
+Result Cpu::free(void *dev_ptr) {
+    std::free(dev_ptr);
+    return SUCCESS;
+}
+
+Result Cpu::memcopy(void *dst, const void *src, uint64_t size, DIRECTION dir) {
+    std::memcpy(dst, src, size);
+    return SUCCESS;
+}
+
+Result Cpu::memcopyAsync(Stream* stream, void *dst, const void *src, uint64_t size, DIRECTION dir) {
+    static_cast<DummyStream*>(stream)->enqueue([dst, src, size]() {
+        std::memcpy(dst, src, size);
+    });
+    return SUCCESS;
+}
+
+std::unique_ptr<Model> Cpu::loadModel(const std::string &path) {
+    auto model = std::make_unique<CpuModel>(this);
+    if (model->load(path) != SUCCESS) {
+        ERROR_LOG("Cpu: 加载模型%s失败", path.c_str());
+        return nullptr;
+    }
+    INFO_LOG("Cpu load model %s success", path.c_str());
+    return model;
+}
+
+Result Cpu::unloadModel(Model* model) {
+    // 权重随CpuModel一起析构
+    return SUCCESS;
+}
+
+Result Cpu::infer(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) {
+    RETURN_IF_ERR(inferAsync(stream, model, dev_input_ptr, dev_output_ptr), "Cpu inferAsync fail");
+    return stream->synchronize();
+}
+
+Result Cpu::inferAsync(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) {
+    auto cpu_model = static_cast<const CpuModel*>(model);
+    size_t batch = model->getInfo()->getBatchSize();
+    auto pool = thread_pool_.get();
+    static_cast<DummyStream*>(stream)->enqueue([cpu_model, batch, pool, dev_input_ptr, dev_output_ptr]() {
+        cpu_model->run(dev_input_ptr, dev_output_ptr, batch, pool);
+    });
+    return SUCCESS;
+}
+
+std::unique_ptr<Stream> Cpu::createStream() {
+    auto stream = std::make_unique<DummyStream>(this);
+    stream->createStream();
+    return stream;
+}
+
+Result Cpu::destoryStream(Stream* stream) {
+    return stream->destoryStream();
+}
+
+std::unique_ptr<Event> Cpu::createEvent() {
+    auto event = std::make_unique<DummyEvent>(this);
+    event->createEvent();
+    return event;
+}
+
+Result Cpu::destoryEvent(Event* event) {
+    return event->destoryEvent();
+}
+
+// 按layers的顺序推导每层的输出形状和权重位置
+Result CpuModel::load(const std::string& path) {
+    YAML::Node config;
+    try {
+        config = YAML::LoadFile(path);
+    } catch (const std::exception& e) {
+        ERROR_LOG("Cpu model %s parse fail: %s", path.c_str(), e.what());
+        return FAIL;
+    }
+    if (config["batch"]) {
+        batch_ = config["batch"].as<size_t>();
+    }
+    auto input = config["input"];
+    auto shape = input["shape"];
+    if (!shape || shape.size() != 3) {
+        ERROR_LOG("Cpu model input shape must be [C, H, W]");
+        return FAIL;
+    }
+    in_c_ = shape[0].as<int>();
+    in_h_ = shape[1].as<int>();
+    in_w_ = shape[2].as<int>();
+    if (input["dtype"]) {
+        input_dtype_ = stringToDataType(input["dtype"].as<std::string>());
+    }
+    if (input_dtype_ != FLOAT32 && input_dtype_ != UINT8) {
+        ERROR_LOG("Cpu model only supports float32 or uint8 input");
+        return FAIL;
+    }
+    if (input["scale"]) {
+        input_scale_ = input["scale"].as<float>();
+    }
+
+    int c = in_c_, h = in_h_, w = in_w_;
+    size_t weight_count = 0;
+    max_size_ = (size_t)c * h * w;
+    for (auto node : config["layers"]) {
+        CpuLayer layer;
+        auto type = node["type"].as<std::string>();
+        if (type == "conv") {
+            layer.type = CPU_CONV;
+            auto& p = layer.conv;
+            p.in_c = c;
+            p.in_h = h;
+            p.in_w = w;
+            p.out_c = node["out_channels"].as<int>();
+            p.kernel = node["kernel"].as<int>();
+            p.stride = node["stride"] ? node["stride"].as<int>() : 1;
+            p.pad = node["pad"] ? node["pad"].as<int>() : 0;
+            p.out_h = (h + 2 * p.pad - p.kernel) / p.stride + 1;
+            p.out_w = (w + 2 * p.pad - p.kernel) / p.stride + 1;
+            layer.weight_offset = weight_count;
+            weight_count += (size_t)p.out_c * p.in_c * p.kernel * p.kernel;
+            layer.bias_offset = weight_count;
+            weight_count += p.out_c;
+            c = p.out_c;
+            h = p.out_h;
+            w = p.out_w;
+        } else if (type == "maxpool" || type == "avgpool") {
+            layer.type = type == "maxpool" ? CPU_MAXPOOL : CPU_AVGPOOL;
+            auto& p = layer.pool;
+            p.channels = c;
+            p.in_h = h;
+            p.in_w = w;
+            p.kernel = node["kernel"].as<int>();
+            p.stride = node["stride"] ? node["stride"].as<int>() : p.kernel;
+            p.out_h = (h - p.kernel) / p.stride + 1;
+            p.out_w = (w - p.kernel) / p.stride + 1;
+            h = p.out_h;
+            w = p.out_w;
+        } else if (type == "fc") {
+            layer.type = CPU_FC;
+            layer.in_features = c * h * w;
+            layer.out_features = node["out_features"].as<int>();
+            layer.weight_offset = weight_count;
+            weight_count += (size_t)layer.in_features * layer.out_features;
+            layer.bias_offset = weight_count;
+            weight_count += layer.out_features;
+            c = layer.out_features;
+            h = w = 1;
+        } else if (type == "relu") {
+            layer.type = CPU_RELU;
+        } else if (type == "softmax") {
+            layer.type = CPU_SOFTMAX;
+        } else if (type == "flatten") {
+            layer.type = CPU_FLATTEN;
+            c = c * h * w;
+            h = w = 1;
+        } else {
+            ERROR_LOG("Cpu model: unknown layer type %s", type.c_str());
+            return FAIL;
+        }
+        if (c <= 0 || h <= 0 || w <= 0) {
+            ERROR_LOG("Cpu model: layer %zu (%s) output shape is invalid", layers_.size(), type.c_str());
+            return FAIL;
+        }
+        layer.out_size = (size_t)c * h * w;
+        max_size_ = std::max(max_size_, layer.out_size);
+        layers_.push_back(layer);
+    }
+    if (layers_.empty()) {
+        ERROR_LOG("Cpu model %s has no layers", path.c_str());
+        return FAIL;
+    }
+
+    // 权重文件是按层顺序拼接的float32(先weight后bias)，路径相对于模型文件
+    if (config["weights"]) {
+        auto file = config["weights"].as<std::string>();
+        if (!file.empty() && file[0] != '/') {
+            auto pos = path.find_last_of('/');
+            if (pos != std::string::npos) {
+                file = path.substr(0, pos + 1) + file;
+            }
+        }
+        RETURN_IF_ERR(loadWeights(file, weight_count), "Cpu model load weights fail");
+    } else {
+        uint32_t seed = config["seed"] ? config["seed"].as<uint32_t>() : 42;
+        randomWeights(weight_count, seed);
+    }
+    info_ = makeInfo();
+    device_bytes_ = weights_.size() * sizeof(float);
+    INFO_LOG("Cpu model %s: %zu layers, %zu parameters", path.c_str(), layers_.size(), weight_count);
+    return SUCCESS;
+}
+
+Result CpuModel::loadWeights(const std::string& path, size_t count) {
+    std::ifstream file(path, std::ifstream::binary);
+    if (!file.is_open()) {
+        ERROR_LOG("Cpu model can not open weights %s", path.c_str());
+        return FAIL;
+    }
+    weights_.resize(count);
+    file.read(reinterpret_cast<char*>(weights_.data()), count * sizeof(float));
+    if ((size_t)file.gcount() != count * sizeof(float)) {
+        ERROR_LOG("Cpu model weights %s size mismatch, need %zu floats", path.c_str(), count);
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
+// 没有权重文件时用固定种子初始化，只用于压测，保证每次结果一致
+void CpuModel::randomWeights(size_t count, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
+    weights_.resize(count);
+    for (auto& v : weights_) {
+        v = dist(gen);
+    }
+}
+
+std::unique_ptr<ModelInfo> CpuModel::makeInfo() const {
+    size_t elem = input_dtype_ == UINT8 ? 1 : 4;
+    size_t input_size = (size_t)in_c_ * in_h_ * in_w_ * elem;
+    auto out_size = layers_.back().out_size;
+    std::vector<std::vector<uint32_t>> ins_dim{{1, (uint32_t)in_c_, (uint32_t)in_h_, (uint32_t)in_w_}};
+    std::vector<std::vector<uint32_t>> outs_dim{{1, (uint32_t)out_size}};
+    return std::make_unique<ModelInfo>(batch_, input_size, out_size * sizeof(float), 1, 1,
+                                       std::move(ins_dim), std::move(outs_dim));
+}
+
+void CpuModel::run(const void* input, void* output, size_t batch, ThreadPool* pool) const {
+    // 中间结果在两个缓冲之间来回倒，每个stream线程各自一份
+    thread_local std::vector<float> ping, pong;
+    if (ping.size() < max_size_) {
+        ping.resize(max_size_);
+        pong.resize(max_size_);
+    }
+    size_t in_size = (size_t)in_c_ * in_h_ * in_w_;
+    size_t out_size = layers_.back().out_size;
+    for (size_t b = 0; b < batch; b++) {
+        float* cur = ping.data();
+        float* next = pong.data();
+        if (input_dtype_ == UINT8) {
+            auto in = static_cast<const uint8_t*>(input) + b * in_size;
+            for (size_t i = 0; i < in_size; i++) {
+                cur[i] = in[i] * input_scale_;
+            }
+        } else {
+            auto in = static_cast<const float*>(input) + b * in_size;
+            for (size_t i = 0; i < in_size; i++) {
+                cur[i] = in[i] * input_scale_;
+            }
+        }
+        size_t cur_size = in_size;
+        for (auto& layer : layers_) {
+            const float* wt = weights_.data() + layer.weight_offset;
+            const float* bias = weights_.data() + layer.bias_offset;
+            switch (layer.type) {
+                case CPU_CONV:
+                    cpu::conv2d(layer.conv, cur, wt, bias, next, pool);
+                    std::swap(cur, next);
+                    break;
+                case CPU_MAXPOOL:
+                    cpu::maxPool2d(layer.pool, cur, next, pool);
+                    std::swap(cur, next);
+                    break;
+                case CPU_AVGPOOL:
+                    cpu::avgPool2d(layer.pool, cur, next, pool);
+                    std::swap(cur, next);
+                    break;
+                case CPU_FC:
+                    cpu::fullyConnected(layer.in_features, layer.out_features, cur, wt, bias, next, pool);
+                    std::swap(cur, next);
+                    break;
+                case CPU_RELU:
+                    cpu::relu(cur, cur_size);
+                    break;
+                case CPU_SOFTMAX:
+                    cpu::softmax(cur, cur_size);
+                    break;
+                case CPU_FLATTEN:
+                    break;
+            }
+            cur_size = layer.out_size;
+        }
+        std::memcpy(static_cast<float*>(output) + b * out_size, cur, out_size * sizeof(float));
+    }
+}
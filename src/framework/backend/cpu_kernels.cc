@@ -0,0 +1,268 @@
+#include "backend/cpu_kernels.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_KERNELS_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define CPU_KERNELS_NEON 1
+#endif
+
+namespace cpu {
+
+namespace {
+
+void axpyScalar(float a, const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+float dotScalar(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#if CPU_KERNELS_X86
+// 用target属性单独编译，不需要整个工程加-mavx2，运行时再决定用不用
+__attribute__((target("avx2,fma")))
+void axpyAvx2(float a, const float* x, float* y, size_t n) {
+    __m256 va = _mm256_set1_ps(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 vy = _mm256_loadu_ps(y + i);
+        vy = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), vy);
+        _mm256_storeu_ps(y + i, vy);
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+float dotAvx2(const float* a, const float* b, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 lo = _mm256_castps256_ps128(acc);
+    __m128 hi = _mm256_extractf128_ps(acc, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_hadd_ps(lo, lo);
+    lo = _mm_hadd_ps(lo, lo);
+    float sum = _mm_cvtss_f32(lo);
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+#endif
+
+#if CPU_KERNELS_NEON
+void axpyNeon(float a, const float* x, float* y, size_t n) {
+    float32x4_t va = vdupq_n_f32(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(y + i, vfmaq_f32(vld1q_f32(y + i), va, vld1q_f32(x + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+float dotNeon(const float* a, const float* b, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+#endif
+
+struct Kernels {
+    void (*axpy)(float, const float*, float*, size_t);
+    float (*dot)(const float*, const float*, size_t);
+    const char* name;
+};
+
+Kernels selectKernels() {
+#if CPU_KERNELS_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return {axpyAvx2, dotAvx2, "avx2"};
+    }
+#elif CPU_KERNELS_NEON
+    return {axpyNeon, dotNeon, "neon"};
+#endif
+    return {axpyScalar, dotScalar, "scalar"};
+}
+
+const Kernels& kernels() {
+    static const Kernels k = selectKernels();
+    return k;
+}
+
+}  // namespace
+
+const char* simdName() {
+    return kernels().name;
+}
+
+void axpy(float a, const float* x, float* y, size_t n) {
+    kernels().axpy(a, x, y, n);
+}
+
+float dot(const float* a, const float* b, size_t n) {
+    return kernels().dot(a, b, n);
+}
+
+// 直接卷积：对每个(ic, kh, kw)，输出的一整行加上权重乘输入的一行
+// stride为1时输入行是连续的，可以用axpy；其他stride逐点计算
+void conv2d(const ConvParam& p, const float* input, const float* weight, const float* bias,
+            float* output, ThreadPool* pool) {
+    const size_t out_plane = (size_t)p.out_h * p.out_w;
+    const size_t in_plane = (size_t)p.in_h * p.in_w;
+    auto body = [&](size_t oc_begin, size_t oc_end) {
+        for (size_t oc = oc_begin; oc < oc_end; oc++) {
+            float* out = output + oc * out_plane;
+            std::fill(out, out + out_plane, bias ? bias[oc] : 0.0f);
+            for (int ic = 0; ic < p.in_c; ic++) {
+                const float* in = input + ic * in_plane;
+                const float* w = weight + ((oc * p.in_c + ic) * p.kernel) * p.kernel;
+                for (int kh = 0; kh < p.kernel; kh++) {
+                    for (int kw = 0; kw < p.kernel; kw++) {
+                        float wv = w[kh * p.kernel + kw];
+                        // 有效的输出列范围[ow_lo, ow_hi)，避免在内层判断padding
+                        int ow_lo = std::max(0, (p.pad - kw + p.stride - 1) / p.stride);
+                        int ow_hi = std::min(p.out_w, (p.in_w + p.pad - kw + p.stride - 1) / p.stride);
+                        if (ow_hi <= ow_lo) {
+                            continue;
+                        }
+                        for (int oh = 0; oh < p.out_h; oh++) {
+                            int ih = oh * p.stride + kh - p.pad;
+                            if (ih < 0 || ih >= p.in_h) {
+                                continue;
+                            }
+                            const float* in_row = in + ih * p.in_w;
+                            float* out_row = out + oh * p.out_w;
+                            if (p.stride == 1) {
+                                axpy(wv, in_row + ow_lo + kw - p.pad, out_row + ow_lo, ow_hi - ow_lo);
+                            } else {
+                                for (int ow = ow_lo; ow < ow_hi; ow++) {
+                                    out_row[ow] += wv * in_row[ow * p.stride + kw - p.pad];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    };
+    if (pool) {
+        pool->parallelFor(0, p.out_c, 1, body);
+    } else {
+        body(0, p.out_c);
+    }
+}
+
+template <bool kMax>
+static void pool2d(const PoolParam& p, const float* input, float* output, ThreadPool* pool) {
+    const size_t in_plane = (size_t)p.in_h * p.in_w;
+    const size_t out_plane = (size_t)p.out_h * p.out_w;
+    const float inv = 1.0f / (p.kernel * p.kernel);
+    auto body = [&](size_t c_begin, size_t c_end) {
+        for (size_t c = c_begin; c < c_end; c++) {
+            const float* in = input + c * in_plane;
+            float* out = output + c * out_plane;
+            for (int oh = 0; oh < p.out_h; oh++) {
+                for (int ow = 0; ow < p.out_w; ow++) {
+                    float acc = kMax ? -INFINITY : 0.0f;
+                    for (int kh = 0; kh < p.kernel; kh++) {
+                        int ih = oh * p.stride + kh;
+                        if (ih >= p.in_h) {
+                            break;
+                        }
+                        for (int kw = 0; kw < p.kernel; kw++) {
+                            int iw = ow * p.stride + kw;
+                            if (iw >= p.in_w) {
+                                break;
+                            }
+                            float v = in[ih * p.in_w + iw];
+                            acc = kMax ? std::max(acc, v) : acc + v;
+                        }
+                    }
+                    out[oh * p.out_w + ow] = kMax ? acc : acc * inv;
+                }
+            }
+        }
+    };
+    if (pool) {
+        pool->parallelFor(0, p.channels, 4, body);
+    } else {
+        body(0, p.channels);
+    }
+}
+
+void maxPool2d(const PoolParam& p, const float* input, float* output, ThreadPool* pool) {
+    pool2d<true>(p, input, output, pool);
+}
+
+void avgPool2d(const PoolParam& p, const float* input, float* output, ThreadPool* pool) {
+    pool2d<false>(p, input, output, pool);
+}
+
+void fullyConnected(int in_features, int out_features, const float* input, const float* weight,
+                    const float* bias, float* output, ThreadPool* pool) {
+    auto body = [&](size_t o_begin, size_t o_end) {
+        for (size_t o = o_begin; o < o_end; o++) {
+            output[o] = dot(weight + o * in_features, input, in_features) + (bias ? bias[o] : 0.0f);
+        }
+    };
+    // 每块至少约16K次乘加，太小的层并行反而更慢
+    size_t grain = std::max<size_t>(1, 16384 / std::max(in_features, 1));
+    if (pool) {
+        pool->parallelFor(0, out_features, grain, body);
+    } else {
+        body(0, out_features);
+    }
+}
+
+void relu(float* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        data[i] = data[i] > 0.0f ? data[i] : 0.0f;
+    }
+}
+
+void softmax(float* data, size_t n) {
+    if (n == 0) {
+        return;
+    }
+    float max = *std::max_element(data, data + n);
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        data[i] = std::exp(data[i] - max);
+        sum += data[i];
+    }
+    for (size_t i = 0; i < n; i++) {
+        data[i] /= sum;
+    }
+}
+
+}  // namespace cpu
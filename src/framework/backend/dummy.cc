@@ -1,120 +1,572 @@
 #include "backend/dummy.h"
+#include "util.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <fstream>
+#include <random>
+#include <yaml-cpp/yaml.h>
 
 Result Dummy::init() {
-    INFO_LOG("Dummy Init Success");
+    INFO_LOG("Dummy[%d] Init Success", device_id_);
     return SUCCESS;
 }
 
 Result Dummy::finalize() {
+    pool_->trim();
+    host_pool_->trim();
     INFO_LOG("Dummy Finalize Success");
     return SUCCESS;
 }
 
 Result Dummy::malloc(void **dev_ptr, uint64_t size) {
-    INFO_LOG("--Dummy Malloc Start--");
+    DEBUG_LOG("--Dummy Malloc Start--");
+    std::lock_guard<std::mutex> lock(alloc_lock_);
+    if (alloc_bytes_ + model_bytes_.load() + size > latency_.memory_bytes) {
+        ERROR_LOG("Dummy[%d] out of device memory: %lu in use, %lu requested, capacity %lu", device_id_,
+                  alloc_bytes_ + model_bytes_.load(), size, latency_.memory_bytes);
+        *dev_ptr = nullptr;
+        return FAIL;
+    }
     *dev_ptr = std::malloc(size);
-    INFO_LOG("Dummy malloc %lu bytes at addr %p", size, *dev_ptr);
+    allocs_[*dev_ptr] = size;
+    alloc_bytes_ += size;
+    DEBUG_LOG("Dummy malloc %lu bytes at addr %p", size, *dev_ptr);
     return SUCCESS;
 }
 
 Result Dummy::free(void *dev_ptr) {
-    INFO_LOG("--Dummy free start--");
+    DEBUG_LOG("--Dummy free start--");
+    {
+        std::lock_guard<std::mutex> lock(alloc_lock_);
+        auto it = allocs_.find(dev_ptr);
+        if (it != allocs_.end()) {
+            alloc_bytes_ -= it->second;
+            allocs_.erase(it);
+        }
+    }
     std::free(dev_ptr);
-    INFO_LOG("Dummy free mem at addr %p", dev_ptr);
+    DEBUG_LOG("Dummy free mem at addr %p", dev_ptr);
     return SUCCESS;
 }
 
 Result Dummy::memcopy(void *dst, const void *src, uint64_t size, DIRECTION dir) {
-    INFO_LOG("--Dummy Memcpy Start--");
-    assert(dir == HOST2HOST);
+    DEBUG_LOG("--Dummy Memcpy Start--");
+    // dummy的"设备内存"就是主机内存，任意方向都是memcpy
+    copyDelay(size);
     std::memcpy(dst, src, size);
-    INFO_LOG("Dummy copied %lu bytes mem form %p to %p", size, src, dst);
+    DEBUG_LOG("Dummy copied %lu bytes mem form %p to %p", size, src, dst);
     return SUCCESS;
 }
 
-uint32_t Dummy::loadModel(const std::string &path) {
+Result Dummy::memcopyAsync(Stream* stream, void *dst, const void *src, uint64_t size, DIRECTION dir) {
+    auto dummy_stream = static_cast<DummyStream*>(stream);
+    dummy_stream->enqueue([this, dst, src, size]() {
+        copyDelay(size);
+        std::memcpy(dst, src, size);
+    });
+    return SUCCESS;
+}
+
+void Dummy::copyDelay(uint64_t size) const {
+    if (latency_.copy_gbps <= 0.0) {
+        return;
+    }
+    // 1GB/s = 1000 bytes/us
+    auto us = static_cast<int64_t>(size / (latency_.copy_gbps * speed_ * 1000.0));
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void Dummy::setModelCost(const std::string& path, const DummyModelCost& cost) {
+    std::lock_guard<std::mutex> lock(cost_lock_);
+    model_costs_[path] = cost;
+}
+
+std::unique_ptr<Model> Dummy::loadModel(const std::string &path) {
     INFO_LOG("--Dummy loadModel Start--");
-    uint32_t id = 114514;
-    {
-        std::lock_guard<std::mutex> lock(model_lock_);
-        if (info_ != nullptr) {
-            return id;
+    DummyModelProfile profile;
+    bool from_file = DummyModelProfile::load(path, profile) == SUCCESS;
+    if (!from_file && DummyModelProfile::isProfile(path)) {
+        // 写错的profile不退回默认模型，按加载失败处理
+        return nullptr;
+    }
+    if (!from_file) {
+        // 没有profile的模型用setModelCost和setBatchSize的设置
+        std::lock_guard<std::mutex> lock(cost_lock_);
+        auto it = model_costs_.find(path);
+        if (it == model_costs_.end()) {
+            it = model_costs_.find("");
+        }
+        if (it != model_costs_.end()) {
+            profile.cost = it->second;
         }
+        profile.batch = batch_size_;
+    }
+    auto& cost = profile.cost;
+    if (cost.load_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(cost.load_ms));
     }
-    size_t batch = 1, output_size = 20, input_size = 20, input_num = 1, output_num = 1;
-    std::vector<std::vector<uint32_t>> ins_dim{{1, 5}};
-    std::vector<std::vector<uint32_t>> outs_dim{{1, 5}};
     {
-        std::lock_guard<std::mutex> lock(model_lock_);
-        if (info_ != nullptr) {
-            return id;
+        std::lock_guard<std::mutex> lock(alloc_lock_);
+        if (alloc_bytes_ + model_bytes_.load() + cost.size_bytes > latency_.memory_bytes) {
+            ERROR_LOG("Dummy[%d] out of device memory loading %s (%lu bytes)", device_id_, path.c_str(),
+                      cost.size_bytes);
+            return nullptr;
+        }
+        model_bytes_.fetch_add(cost.size_bytes);
+    }
+    // ModelInfo里的大小是单个样本的；Executor按output_size给每个输出分配，多个输出需要一样大
+    size_t input_size = 0;
+    for (size_t i = 0; i < profile.inputs_shape.size(); i++) {
+        input_size += Tensor::view(nullptr, profile.inputs_shape[i], profile.inputs_dtype[i]).size();
+    }
+    size_t output_size = Tensor::view(nullptr, profile.outputs_shape[0], profile.outputs_dtype[0]).size();
+    for (size_t i = 1; i < profile.outputs_shape.size(); i++) {
+        if (Tensor::view(nullptr, profile.outputs_shape[i], profile.outputs_dtype[i]).size() != output_size) {
+            WARN_LOG("Dummy model %s: output %zu size differs from output 0, executor assumes equal sizes",
+                     path.c_str(), i);
+        }
+    }
+    auto ins_dim = profile.inputs_shape;
+    auto outs_dim = profile.outputs_shape;
+    auto info = std::make_unique<ModelInfo>(profile.batch, input_size, output_size, ins_dim.size(), outs_dim.size(),
+        std::move(ins_dim), std::move(outs_dim));
+    INFO_LOG("Dummy load model %s success%s", path.c_str(), from_file ? " (profile)" : "");
+    return std::make_unique<DummyModel>(this, std::move(info), std::move(profile));
+}
+
+// 解析 [1, 3, 224, 224] 和 dtype，tensors为 [{shape: [...], dtype: float32}, ...]；dtype不认识时返回FAIL
+static Result parseTensors(const YAML::Node& tensors, std::vector<std::vector<uint32_t>>& shapes,
+                           std::vector<DataType>& dtypes) {
+    shapes.clear();
+    dtypes.clear();
+    for (auto t : tensors) {
+        shapes.push_back(t["shape"].as<std::vector<uint32_t>>());
+        std::string dtype = t["dtype"] ? t["dtype"].as<std::string>() : "float32";
+        if (!isDataTypeName(dtype)) {
+            ERROR_LOG("Dummy: unknown dtype %s in model profile", dtype.c_str());
+            return FAIL;
+        }
+        dtypes.push_back(stringToDataType(dtype));
+    }
+    return SUCCESS;
+}
+
+static Result parseProfile(const YAML::Node& config, DummyModelProfile& profile);
+
+bool DummyModelProfile::isProfile(const std::string& path) {
+    return (path.size() >= 5 && path.compare(path.size() - 5, 5, ".yaml") == 0) ||
+           (path.size() >= 4 && path.compare(path.size() - 4, 4, ".yml") == 0);
+}
+
+Result DummyModelProfile::load(const std::string& path, DummyModelProfile& profile) {
+    if (!isProfile(path)) {
+        return FAIL;
+    }
+    // 在executor线程上加载，字段类型写错时as<>()抛出的异常不能漏出去；解析完整成功才写回profile
+    DummyModelProfile parsed = profile;
+    Result res = FAIL;
+    try {
+        res = parseProfile(YAML::LoadFile(path), parsed);
+    } catch (const YAML::Exception& e) {
+        ERROR_LOG("Dummy: can not load model profile %s: %s", path.c_str(), e.what());
+        return FAIL;
+    }
+    if (res != SUCCESS) {
+        ERROR_LOG("Dummy: invalid model profile %s", path.c_str());
+        return FAIL;
+    }
+    profile = std::move(parsed);
+    return SUCCESS;
+}
+
+static Result parseProfile(const YAML::Node& config, DummyModelProfile& profile) {
+    if (config["batch"]) {
+        profile.batch = std::max<size_t>(1, config["batch"].as<size_t>());
+    }
+    if (config["inputs"]) {
+        RETURN_IF_ERR(parseTensors(config["inputs"], profile.inputs_shape, profile.inputs_dtype),
+                      "Dummy: bad inputs in model profile");
+    }
+    if (config["outputs"]) {
+        RETURN_IF_ERR(parseTensors(config["outputs"], profile.outputs_shape, profile.outputs_dtype),
+                      "Dummy: bad outputs in model profile");
+    }
+    if (profile.inputs_shape.empty() || profile.outputs_shape.empty()) {
+        ERROR_LOG("Dummy: model profile needs at least one input and one output");
+        return FAIL;
+    }
+    if (auto lat = config["latency"]) {
+        profile.has_latency = true;
+        if (lat["fixed_us"]) {
+            profile.fixed_us = lat["fixed_us"].as<double>();
+        }
+        if (lat["per_sample_us"]) {
+            profile.per_sample_us = lat["per_sample_us"].as<double>();
+        }
+        if (auto jitter = lat["jitter"]) {
+            if (jitter["dist"]) {
+                profile.jitter.dist = jitter["dist"].as<std::string>();
+            }
+            if (jitter["us"]) {
+                profile.jitter.us = jitter["us"].as<double>();
+            }
+            if (jitter["sigma"]) {
+                profile.jitter.sigma = jitter["sigma"].as<double>();
+            }
+            auto& dist = profile.jitter.dist;
+            if (dist != "none" && dist != "uniform" && dist != "normal" && dist != "exponential" &&
+                dist != "lognormal") {
+                ERROR_LOG("Dummy: unknown jitter dist %s in model profile", dist.c_str());
+                return FAIL;
+            }
+            // 分布参数为负时std的分布未定义
+            if (profile.jitter.us < 0.0 || profile.jitter.sigma < 0.0) {
+                ERROR_LOG("Dummy: jitter us and sigma must not be negative");
+                return FAIL;
+            }
         }
-        info_ = std::make_unique<ModelInfo>(batch, input_size, output_size, input_num, output_num, 
-            std::move(ins_dim), std::move(outs_dim));
     }
-    INFO_LOG("Dummy load model success, id = %d", id);
-    return id;
+    if (config["size_mb"]) {
+        profile.cost.size_bytes = (uint64_t)(config["size_mb"].as<double>() * (1 << 20));
+    }
+    if (config["load_ms"]) {
+        profile.cost.load_ms = config["load_ms"].as<uint32_t>();
+    }
+    if (auto dev = config["device"]) {
+        if (dev["copy_gbps"]) {
+            profile.device.copy_gbps = dev["copy_gbps"].as<double>();
+        }
+        if (dev["max_concurrency"]) {
+            profile.device.max_concurrency = dev["max_concurrency"].as<uint32_t>();
+        }
+        if (dev["memory_gb"]) {
+            profile.device.memory_bytes = (uint64_t)(dev["memory_gb"].as<double>() * (1ull << 30));
+        }
+    }
+    return SUCCESS;
+}
+
+double DummyModelProfile::sampleLatencyUs(size_t batch) const {
+    double us = fixed_us + per_sample_us * batch;
+    if (jitter.dist == "none") {
+        return us;
+    }
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    if (jitter.dist == "uniform") {
+        us += std::uniform_real_distribution<double>(0.0, jitter.us)(rng);
+    } else if (jitter.dist == "normal") {
+        us += std::normal_distribution<double>(0.0, jitter.us)(rng);
+    } else if (jitter.dist == "exponential") {
+        us += jitter.us > 0.0 ? std::exponential_distribution<double>(1.0 / jitter.us)(rng) : 0.0;
+    } else if (jitter.dist == "lognormal") {
+        // 长尾：中位数不变，sigma越大尾部越长
+        us *= std::lognormal_distribution<double>(0.0, jitter.sigma)(rng);
+    }
+    return std::max(0.0, us);
 }
 
-Result Dummy::unloadModel(const std::string& path) {
+Result Dummy::unloadModel(Model* model) {
     INFO_LOG("--Dummy UnloadModel Start--");
+    model_bytes_.fetch_sub(model->getDeviceBytes());
     INFO_LOG("Dummy unload model success");
     return SUCCESS;
 }
 
-Result Dummy::infer(Stream* stream, uint32_t model_id, void* dev_input_ptr, void* dev_output_ptr) {
-    // std::lock_guard<std::mutex> lock(model_lock_);
-    // if (!info_) {
-    //     ERROR_LOG("Dummy infer failed: no model loaded");
-    //     return FAIL;
-    // }
-    INFO_LOG("--Dummy infer Start--");
-    float* input = static_cast<float*>(dev_input_ptr);
-    float* output = static_cast<float*>(dev_output_ptr);
-    int len = 5;
-    float cons = 1.0;
-    for (int i = 0; i < len; i++) {
-        output[i] = input[i] + cons;
-    }
-    INFO_LOG("Dummy infer success");
+Result Dummy::infer(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) {
+    DEBUG_LOG("--Dummy infer Start--");
+    RETURN_IF_ERR(inferAsync(stream, model, dev_input_ptr, dev_output_ptr), "Dummy inferAsync fail");
+    RETURN_IF_ERR(stream->synchronize(), "Dummy stream synchronize fail");
+    DEBUG_LOG("Dummy infer success");
     return SUCCESS;
 }
 
+Result Dummy::inferAsync(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) {
+    auto dummy_stream = static_cast<DummyStream*>(stream);
+    // 推理期间executor持有模型句柄，profile一直有效
+    auto& profile = static_cast<const DummyModel*>(model)->getProfile();
+    double infer_us = profile.has_latency ? profile.sampleLatencyUs(profile.batch) : latency_.infer_us;
+    dummy_stream->enqueue([this, &profile, infer_us, dev_input_ptr, dev_output_ptr]() {
+        uint32_t limit = latency_.max_concurrency;
+        if (limit > 0) {
+            // 计算单元都被占用时排队，stream越多排队越久，吞吐不再增加
+            std::unique_lock<std::mutex> lock(exec_lock_);
+            exec_cond_.wait(lock, [this, limit] { return executing_ < limit; });
+            executing_++;
+        }
+        auto begin = Clock::now();
+        if (infer_us > 0) {
+            // 接近温度上限时驱动降频
+            double slowdown = temperature() >= kTemperatureLimit - kThrottleMargin ? 2.0 : 1.0;
+            std::this_thread::sleep_for(std::chrono::microseconds(
+                static_cast<int64_t>(infer_us * slowdown / speed_)));
+        }
+        runModel(profile, dev_input_ptr, dev_output_ptr);
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin).count();
+        busy_us_.fetch_add(us, std::memory_order_relaxed);
+        if (limit > 0) {
+            {
+                std::lock_guard<std::mutex> lock(exec_lock_);
+                executing_--;
+            }
+            exec_cond_.notify_one();
+        }
+    });
+    return SUCCESS;
+}
+
+uint32_t Dummy::usageRate() {
+    std::lock_guard<std::mutex> lock(usage_lock_);
+    auto now = Clock::now();
+    auto busy = busy_us_.load(std::memory_order_relaxed);
+    auto wall = std::chrono::duration_cast<std::chrono::microseconds>(now - last_sample_).count();
+    uint64_t rate = 0;
+    if (wall > 0) {
+        // 多个stream并发推理时可能超过100%
+        rate = std::min<uint64_t>(100, (busy - last_busy_us_) * 100 / wall);
+    }
+    last_busy_us_ = busy;
+    last_sample_ = now;
+    // 满载时稳定在85度左右，按时间常数一阶惯性逼近，与采样频率无关
+    double target = kTemperatureIdle + rate * 0.45;
+    double alpha = 1.0 - std::exp(-wall / 1e6 / kThermalTauSec);
+    double temp = temperature_.load(std::memory_order_relaxed);
+    temperature_.store(temp + (target - temp) * alpha, std::memory_order_relaxed);
+    return static_cast<uint32_t>(rate);
+}
+
+int32_t Dummy::temperature() const {
+    DummyTelemetryPoint point;
+    if (scripted(point)) {
+        return point.temperature;
+    }
+    return (int32_t)temperature_.load(std::memory_order_relaxed);
+}
+
+uint64_t Dummy::memoryUsed() const {
+    DummyTelemetryPoint point;
+    if (scripted(point) && point.memory_rate >= 0.0) {
+        return static_cast<uint64_t>(point.memory_rate * latency_.memory_bytes);
+    }
+    std::lock_guard<std::mutex> lock(alloc_lock_);
+    return alloc_bytes_ + model_bytes_.load();
+}
+
+void Dummy::setTelemetryScript(std::vector<DummyTelemetryPoint> script) {
+    std::sort(script.begin(), script.end(),
+              [](const DummyTelemetryPoint& a, const DummyTelemetryPoint& b) { return a.at_ms < b.at_ms; });
+    std::lock_guard<std::mutex> lock(script_lock_);
+    script_ = std::move(script);
+    script_begin_ = Clock::now();
+    has_script_.store(!script_.empty());
+}
+
+bool Dummy::scripted(DummyTelemetryPoint& point) const {
+    if (!has_script_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(script_lock_);
+    if (script_.empty()) {
+        return false;
+    }
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - script_begin_).count();
+    auto next = std::find_if(script_.begin(), script_.end(),
+                             [ms](const DummyTelemetryPoint& p) { return p.at_ms > ms; });
+    if (next == script_.begin() || next == script_.end()) {
+        point = next == script_.end() ? script_.back() : script_.front();
+        return true;
+    }
+    auto& a = *(next - 1);
+    auto& b = *next;
+    double t = (ms - a.at_ms) / (b.at_ms - a.at_ms);
+    point.at_ms = static_cast<uint32_t>(ms);
+    point.temperature = static_cast<int32_t>(std::lround(a.temperature + (b.temperature - a.temperature) * t));
+    // 有一端不覆盖时按阶跃处理
+    point.memory_rate = a.memory_rate >= 0.0 && b.memory_rate >= 0.0
+                            ? a.memory_rate + (b.memory_rate - a.memory_rate) * t
+                            : a.memory_rate;
+    return true;
+}
+
+// 输出由输入循环填充：输入输出都是float32时每个元素加1，否则按字节拷贝；耗时只由sleep模拟
+void Dummy::runModel(const DummyModelProfile& profile, void* dev_input_ptr, void* dev_output_ptr) const {
+    size_t in_bytes = 0;
+    for (size_t i = 0; i < profile.inputs_shape.size(); i++) {
+        in_bytes += Tensor::view(nullptr, profile.inputs_shape[i], profile.inputs_dtype[i]).size();
+    }
+    in_bytes *= profile.batch;
+    size_t out_bytes = Tensor::view(nullptr, profile.outputs_shape[0], profile.outputs_dtype[0]).size() *
+                       profile.outputs_shape.size() * profile.batch;
+    if (in_bytes == 0 || out_bytes == 0) {
+        return;
+    }
+    if (profile.inputs_dtype[0] == FLOAT32 && profile.outputs_dtype[0] == FLOAT32) {
+        const float* input = static_cast<const float*>(dev_input_ptr);
+        float* output = static_cast<float*>(dev_output_ptr);
+        size_t in_len = in_bytes / sizeof(float), out_len = out_bytes / sizeof(float);
+        for (size_t i = 0; i < out_len; i++) {
+            output[i] = input[i % in_len] + 1.0f;
+        }
+        return;
+    }
+    auto input = static_cast<const uint8_t*>(dev_input_ptr);
+    auto output = static_cast<uint8_t*>(dev_output_ptr);
+    for (size_t done = 0; done < out_bytes; done += in_bytes) {
+        std::memcpy(output + done, input, std::min(in_bytes, out_bytes - done));
+    }
+}
+
 std::unique_ptr<Stream> Dummy::createStream() {
-    INFO_LOG("--Dummy createStream Start--");
+    DEBUG_LOG("--Dummy createStream Start--");
     std::unique_ptr<DummyStream> dummy_stream = std::make_unique<DummyStream>(this);
     dummy_stream->createStream();
     return dummy_stream;
 }
 
-const ModelInfo* Dummy::getModelInfo(uint32_t model_id) const {
-    std::lock_guard<std::mutex> lock(model_lock_);
-    INFO_LOG("--Dummy getModelInfo Start--");
-    INFO_LOG("Dummy get %d model info", model_id);
-    return info_.get();
-}
-
 Result Dummy::destoryStream(Stream* stream) {
-    INFO_LOG("--Dummy destoryStream Start--");
+    DEBUG_LOG("--Dummy destoryStream Start--");
     stream->destoryStream();
-    INFO_LOG("Dummy destoryStream success");
+    DEBUG_LOG("Dummy destoryStream success");
     return SUCCESS;
 }
 
+std::unique_ptr<Event> Dummy::createEvent() {
+    auto event = std::make_unique<DummyEvent>(this);
+    event->createEvent();
+    return event;
+}
+
+Result Dummy::destoryEvent(Event* event) {
+    return event->destoryEvent();
+}
+
 Result DummyStream::createStream() {
     INFO_LOG("#### DummyStream create stream success ####");
     stream_ = std::malloc(1);
     assert(stream_ != nullptr);
+    stop_ = false;
+    worker_ = std::thread(&DummyStream::loop, this);
     return SUCCESS;
 }
 
 Result DummyStream::destoryStream() {
+    if (stream_ == nullptr) {
+        return SUCCESS;
+    }
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
     INFO_LOG("#### DummyStream destory stream success ####");
     std::free(stream_);
+    stream_ = nullptr;
+    return SUCCESS;
+}
+
+// 退出前会把已放入的操作全部执行完
+void DummyStream::loop() {
+    while (true) {
+        std::function<void()> op;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            cond_.wait(lock, [this] { return stop_ || !ops_.empty(); });
+            if (ops_.empty()) {
+                return;
+            }
+            op = std::move(ops_.front());
+            ops_.pop_front();
+            busy_ = true;
+        }
+        op();
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            busy_ = false;
+            if (ops_.empty()) {
+                idle_cond_.notify_all();
+            }
+        }
+    }
+}
+
+void DummyStream::enqueue(std::function<void()> op) {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        ops_.push_back(std::move(op));
+    }
+    cond_.notify_one();
+}
+
+Result DummyStream::synchronize() {
+    std::unique_lock<std::mutex> lock(lock_);
+    idle_cond_.wait(lock, [this] { return ops_.empty() && !busy_; });
+    return SUCCESS;
+}
+
+Result DummyStream::recordEvent(Event* event) {
+    auto dummy_event = static_cast<DummyEvent*>(event);
+    auto seq = dummy_event->record();
+    enqueue([dummy_event, seq]() { dummy_event->complete(seq); });
+    return SUCCESS;
+}
+
+Result DummyStream::waitEvent(Event* event) {
+    auto dummy_event = static_cast<DummyEvent*>(event);
+    // 等待的是调用时最近一次record
+    auto seq = dummy_event->latest();
+    enqueue([dummy_event, seq]() { dummy_event->waitFor(seq); });
+    return SUCCESS;
+}
+
+Result DummyStream::addCallback(std::function<void()> cb) {
+    enqueue(std::move(cb));
     return SUCCESS;
 }
 
 void* DummyStream::getStream() {
     return stream_;
 }
+
+Result DummyEvent::createEvent() {
+    return SUCCESS;
+}
+
+Result DummyEvent::destoryEvent() {
+    return synchronize();
+}
+
+Result DummyEvent::synchronize() {
+    std::unique_lock<std::mutex> lock(lock_);
+    cond_.wait(lock, [this] { return completed_ >= recorded_; });
+    return SUCCESS;
+}
+
+void* DummyEvent::getEvent() {
+    return this;
+}
+
+uint64_t DummyEvent::record() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return ++recorded_;
+}
+
+uint64_t DummyEvent::latest() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return recorded_;
+}
+
+void DummyEvent::complete(uint64_t seq) {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        completed_ = std::max(completed_, seq);
+    }
+    cond_.notify_all();
+}
+
+void DummyEvent::waitFor(uint64_t seq) {
+    std::unique_lock<std::mutex> lock(lock_);
+    cond_.wait(lock, [this, seq] { return completed_ >= seq; });
+}
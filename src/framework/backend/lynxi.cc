@@ -5,7 +5,10 @@ Lynxi::Lynxi(int dev_id) : Backend(BACKEND_LYNXI, dev_id) {
     // lynSetDevice(dev_id);
 }
 
-Lynxi::~Lynxi() {}
+Lynxi::~Lynxi() {
+    pool_->trim();
+    host_pool_->trim();
+}
 
 
 Result Lynxi::init() {
@@ -21,6 +24,9 @@ Result Lynxi::init() {
 }
 
 Result Lynxi::finalize() {
+    // 缓存的设备内存要在ctx销毁前还回去
+    pool_->trim();
+    host_pool_->trim();
     auto err = lynDestroyContext(ctx_);
     if (err != 0) {
         ERROR_LOG("lynxi销毁ctx失败");
@@ -29,6 +35,15 @@ Result Lynxi::finalize() {
     return SUCCESS;
 }
 
+Result Lynxi::bindThread() {
+    lynError_t err = lynSetCurrentContext(ctx_);
+    if (err != 0) {
+        ERROR_LOG("lynxi设置当前线程ctx失败,设备id为%d", device_id_);
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
 Result Lynxi::memcopy(void *dst, const void *src, uint64_t size, DIRECTION dir) {
     lynError_t err;
     if (dir == DEVICE2HOST) {
@@ -46,6 +61,24 @@ Result Lynxi::memcopy(void *dst, const void *src, uint64_t size, DIRECTION dir)
     return SUCCESS;
 }
 
+Result Lynxi::memcopyAsync(Stream* stream, void *dst, const void *src, uint64_t size, DIRECTION dir) {
+    lynStream_t lynstream = stream->getStream();
+    lynError_t err;
+    if (dir == DEVICE2HOST) {
+        err = lynMemcpyAsync(lynstream, dst, src, size, ServerToClient);
+    } else if (dir == HOST2DEVICE) {
+        err = lynMemcpyAsync(lynstream, dst, src, size, ClientToServer);
+    } else {
+        ERROR_LOG("未知的内存拷贝方向");
+        return FAIL;
+    }
+    if (err != 0) {
+        ERROR_LOG("异步内存拷贝失败");
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
 Result Lynxi::malloc(void **dev_ptr, uint64_t size) {
     lynError_t err = lynMalloc(dev_ptr, size);
     if (err != 0) {
@@ -65,106 +98,88 @@ Result Lynxi::free(void *dev_ptr) {
     return SUCCESS;
 }
 
-// 加载模型，同时创建modelinfo，返回model_id
-uint32_t Lynxi::loadModel(const std::string &path) {
+Result Lynxi::mallocHost(void **host_ptr, size_t size) {
+    lynError_t err = lynHostMalloc(host_ptr, size);
+    if (err != 0) {
+        ERROR_LOG("lynxi: 分配锁页内存失败");
+        *host_ptr = nullptr;
+        return FAIL;
+    }
+    return SUCCESS;
+}
 
-    // 判断模型是否已加载
-    {
-        std::lock_guard<std::mutex> lock(model_lock_);
-        auto it = path_to_id_.find(path);
-        if (it != path_to_id_.end()) {
-            return it->second;
-        }
+Result Lynxi::freeHost(void *host_ptr) {
+    lynError_t err = lynHostFree(host_ptr);
+    if (err != 0) {
+        ERROR_LOG("lynxi: 释放锁页内存失败");
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
+// 加载模型，同时创建modelinfo
+std::unique_ptr<Model> Lynxi::loadModel(const std::string &path) {
+    // 最后一个句柄可能在任意线程上释放，加载卸载前都先绑定本卡的上下文
+    if (bindThread() != SUCCESS) {
+        return nullptr;
     }
-    // load model
     lynModel_t model;
-    lynError_t err = lynLoadModel(path.c_str(), &model); // loadModel是线程安全吗
+    lynError_t err = lynLoadModel(path.c_str(), &model);
     if (err != 0) {
         ERROR_LOG("lynxi: 加载模型错误");
-        return -1;
+        return nullptr;
     }
 
-    {
-        std::lock_guard<std::mutex> lock(model_lock_);
-        auto it = path_to_id_.find(path);
-        if (it != path_to_id_.end()) {
-            lynUnloadModel(model);
-            return it->second;
-        }
-
-        int model_id = next_model_id_++;
-
-        lynModelDesc_t *model_desc = nullptr;
-        err = lynModelGetDesc(model, &model_desc);
-        if (err != 0) {
-            lynUnloadModel(model);
-            ERROR_LOG("lynxi: 获取modelDesc失败");
-            return -1;
-        }
-        assert(model_desc->inputDataLen != 0);
-        assert(model_desc->outputDataLen != 0);
-
-        size_t batch_size = model_desc->inputTensorAttrArray->batchSize;
-        size_t input_size, output_size;
-        uint32_t input_num, output_num;
-        lynModelGetInputDataTotalLen(model, &input_size);
-        lynModelGetOutputDataTotalLen(model, &output_size);
-        lynModelGetOutputTensorNum(model, &output_num);
-        lynModelGetInputTensorNum(model, &input_num);
-        
-        std::vector<std::vector<uint32_t>> outs_dim;
-        for (int i = 0; i < output_num; i++) {
-            uint32_t dim_count = 0;
-            std::vector<uint32_t> dim(sizeof(uint32_t) * LYN_MAX_DIMS_COUNT);
-            lynModelGetOutputTensorDimsByIndex(model, i, dim.data(), &dim_count);
-            dim.resize(dim_count);
-            outs_dim.emplace_back(std::move(dim));
-        }
-        std::vector<std::vector<uint32_t>> ins_dim;
-        for (int i = 0; i < input_num; i++) {
-            uint32_t dim_count = 0;
-            std::vector<uint32_t> dim(sizeof(uint32_t) * LYN_MAX_DIMS_COUNT);
-            lynModelGetInputTensorDimsByIndex(model, i, dim.data(), &dim_count);
-            dim.resize(dim_count);
-            ins_dim.emplace_back(std::move(dim));
-        }
-
-        path_to_id_[path] = model_id;
-        models_[model_id] = std::make_unique<LynxiModel>(this, model);
-        infos_[model_id] = std::make_unique<ModelInfo>(
-            batch_size,
-            input_size,
-            output_size,
-            input_num,
-            output_num,
-            std::move(ins_dim),
-            std::move(outs_dim)
-        );
-
-        return model_id;
+    lynModelDesc_t *model_desc = nullptr;
+    err = lynModelGetDesc(model, &model_desc);
+    if (err != 0) {
+        lynUnloadModel(model);
+        ERROR_LOG("lynxi: 获取modelDesc失败");
+        return nullptr;
     }
+    assert(model_desc->inputDataLen != 0);
+    assert(model_desc->outputDataLen != 0);
+
+    size_t batch_size = model_desc->inputTensorAttrArray->batchSize;
+    size_t input_size, output_size;
+    uint32_t input_num, output_num;
+    lynModelGetInputDataTotalLen(model, &input_size);
+    lynModelGetOutputDataTotalLen(model, &output_size);
+    lynModelGetOutputTensorNum(model, &output_num);
+    lynModelGetInputTensorNum(model, &input_num);
+
+    std::vector<std::vector<uint32_t>> outs_dim;
+    for (int i = 0; i < output_num; i++) {
+        uint32_t dim_count = 0;
+        std::vector<uint32_t> dim(sizeof(uint32_t) * LYN_MAX_DIMS_COUNT);
+        lynModelGetOutputTensorDimsByIndex(model, i, dim.data(), &dim_count);
+        dim.resize(dim_count);
+        outs_dim.emplace_back(std::move(dim));
+    }
+    std::vector<std::vector<uint32_t>> ins_dim;
+    for (int i = 0; i < input_num; i++) {
+        uint32_t dim_count = 0;
+        std::vector<uint32_t> dim(sizeof(uint32_t) * LYN_MAX_DIMS_COUNT);
+        lynModelGetInputTensorDimsByIndex(model, i, dim.data(), &dim_count);
+        dim.resize(dim_count);
+        ins_dim.emplace_back(std::move(dim));
+    }
+
+    auto info = std::make_unique<ModelInfo>(
+        batch_size,
+        input_size,
+        output_size,
+        input_num,
+        output_num,
+        std::move(ins_dim),
+        std::move(outs_dim)
+    );
+    return std::make_unique<LynxiModel>(this, model, std::move(info));
 }
 
-Result Lynxi::unloadModel(const std::string& path) {
-    lynModel_t model;
-    {
-        std::lock_guard<std::mutex> lock(model_lock_);
-        if (path_to_id_.find(path) == path_to_id_.end()) {
-            return SUCCESS;
-        }
-        int model_id = path_to_id_[path];
-        auto it = models_.find(model_id);
-        if (it == models_.end()) {
-            ERROR_LOG("未找到模型句柄,unload失败");
-            return FAIL;
-        }
-        model = (lynModel_t)it->second->getHandle();
-
-        path_to_id_.erase(path);
-        models_.erase(model_id);
-        infos_.erase(model_id);
-    }
-    auto err = lynUnloadModel(model);
+Result Lynxi::unloadModel(Model* model) {
+    RETURN_IF_ERR(bindThread(), "lynxi bind context fail");
+    auto err = lynUnloadModel((lynModel_t)model->getHandle());
     if (err != 0) {
         ERROR_LOG("lynxi: 卸载模型失败");
         return FAIL;
@@ -172,36 +187,20 @@ Result Lynxi::unloadModel(const std::string& path) {
     return SUCCESS;
 }
 
-Result Lynxi::infer(Stream* stream, uint32_t model_id, void* dev_input_ptr, void* dev_output_ptr) {
-    lynStream_t lynstream = stream->getStream();
-    lynModel_t model;
-    size_t batch_size;
-
-    {
-        std::lock_guard<std::mutex> lock(model_lock_);
-        auto it_model = models_.find(model_id);
-        auto it_info  = infos_.find(model_id);
-        if (it_model == models_.end() || it_info == infos_.end()) {
-            ERROR_LOG("model或model_info不存在");
-            return FAIL;
-        }
-        model = (lynModel_t)it_model->second->getHandle();
-        batch_size = it_info->second->getBatchSize();
-    }
-
-    lynExecuteModelAsync(lynstream, model, dev_input_ptr, dev_output_ptr, batch_size);
-    lynSynchronizeStream(lynstream);
-    return SUCCESS;
+Result Lynxi::infer(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) {
+    RETURN_IF_ERR(inferAsync(stream, model, dev_input_ptr, dev_output_ptr), "lynxi inferAsync fail");
+    return stream->synchronize();
 }
 
-const ModelInfo* Lynxi::getModelInfo(uint32_t model_id) const {
-    std::lock_guard<std::mutex> lock(model_lock_);
-    auto it = infos_.find(model_id);
-    if (it == infos_.end()) {
-        ERROR_LOG("ModelInfo不存在");
-        return nullptr;
+Result Lynxi::inferAsync(Stream* stream, const Model* model, void* dev_input_ptr, void* dev_output_ptr) {
+    lynStream_t lynstream = stream->getStream();
+    auto err = lynExecuteModelAsync(lynstream, (lynModel_t)model->getHandle(), dev_input_ptr, dev_output_ptr,
+                                    model->getInfo()->getBatchSize());
+    if (err != 0) {
+        ERROR_LOG("lynxi execute model failed!");
+        return FAIL;
     }
-    return it->second.get();
+    return SUCCESS;
 }
 
 std::unique_ptr<Stream> Lynxi::createStream() {
@@ -220,7 +219,17 @@ Result Lynxi::destoryStream(Stream* stream) {
     return stream->destoryStream();
 }
 
-void* LynxiModel::getHandle() {
+std::unique_ptr<Event> Lynxi::createEvent() {
+    auto event = std::make_unique<LynxiEvent>(this);
+    event->createEvent();
+    return event;
+}
+
+Result Lynxi::destoryEvent(Event* event) {
+    return event->destoryEvent();
+}
+
+void* LynxiModel::getHandle() const {
     return model_;
 }
 
@@ -269,6 +278,26 @@ Result LynxiStream::waitEvent(Event* event) {
     return SUCCESS;
 }
 
+// lynxi回调的参数只有一个void*，这里把std::function放到堆上转交
+static lynError_t streamCallback(void* user_data) {
+    auto cb = static_cast<std::function<void()>*>(user_data);
+    (*cb)();
+    delete cb;
+    return 0;
+}
+
+Result LynxiStream::addCallback(std::function<void()> cb) {
+    auto user_data = new std::function<void()>(std::move(cb));
+    // 异步回调不阻塞stream，后续拷贝和推理可以继续执行
+    auto err = lynStreamAddAsyncCallback(stream_, streamCallback, user_data);
+    if (err != 0) {
+        delete user_data;
+        ERROR_LOG("lynxi add stream callback failed!");
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
 void* LynxiStream::getStream() {
     return stream_;
 }
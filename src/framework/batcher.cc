@@ -0,0 +1,143 @@
+#include "batcher.h"
+#include "affinity.h"
+
+Batcher::Batcher(TaskQueue* tq, size_t max_batch, const BatcherCfg& cfg)
+    : tq_(tq)
+    , max_batch_(max_batch)
+    , cfg_(cfg) {
+        assert(max_batch_ > 0);
+    }
+
+Batcher::~Batcher() {
+    stop();
+}
+
+void Batcher::start() {
+    stop_ = false;
+    worker_ = std::thread(&Batcher::loop, this);
+    INFO_LOG("Batcher started, max batch = %zu, max delay = %u us", max_batch_, cfg_.max_batch_delay_us);
+}
+
+void Batcher::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        pending_.push_back({std::move(task), Clock::now()});
+    }
+    cond_.notify_one();
+}
+
+void Batcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    cond_.notify_one();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool Batcher::isPreferred(size_t n) const {
+    return std::find(cfg_.preferred_batch_sizes.begin(), cfg_.preferred_batch_sizes.end(), n)
+           != cfg_.preferred_batch_sizes.end();
+}
+
+void Batcher::loop() {
+    setThreadName("batcher");
+    while (true) {
+        std::vector<Pending> batch;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            cond_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            // 以最早到达的请求计算deadline
+            auto deadline = pending_.front().arrival + std::chrono::microseconds(cfg_.max_batch_delay_us);
+            cond_.wait_until(lock, deadline, [this] {
+                return stop_ || pending_.size() >= max_batch_ || isPreferred(pending_.size());
+            });
+            size_t n = std::min(pending_.size(), max_batch_);
+            batch.reserve(n);
+            for (size_t i = 0; i < n; i++) {
+                batch.push_back(std::move(pending_.front()));
+                pending_.pop_front();
+            }
+        }
+        dispatch(std::move(batch));
+    }
+}
+
+// 把n个单样本任务拼成一个满batch的任务，输出回来后再按样本切开
+void Batcher::dispatch(std::vector<Pending>&& batch) {
+    size_t n = batch.size();
+    size_t input_num = batch[0].task.inputs.size();
+
+    std::vector<Tensor> inputs;
+    inputs.reserve(input_num);
+    for (size_t i = 0; i < input_num; i++) {
+        const Tensor& sample = batch[0].task.inputs[i];
+        auto shape = sample.shape();
+        if (shape.empty()) {
+            shape.push_back(max_batch_);
+        } else {
+            shape[0] *= max_batch_;
+        }
+        inputs.emplace_back(shape, sample.dataType());
+        Tensor& tensor = inputs.back();
+        auto dst = tensor.as<uint8_t>();
+        size_t sample_size = sample.size();
+        for (size_t j = 0; j < n; j++) {
+            assert(batch[j].task.inputs[i].size() == sample_size);
+            std::memcpy(dst + j * sample_size, batch[j].task.inputs[i].as<uint8_t>(), sample_size);
+        }
+        // 补零填满batch
+        std::memset(dst + n * sample_size, 0, (max_batch_ - n) * sample_size);
+    }
+
+    // 合并后的任务以最早到达的请求作为入队时间
+    auto enqueue = batch[0].task.times.enqueue;
+    // 合并后的任务取最高的优先级；deadline取最晚的，只有全部过期时才整批丢弃，有一个不限则不限
+    auto subs = std::make_shared<std::vector<Task>>();
+    subs->reserve(n);
+    int priority = batch[0].task.priority;
+    uint64_t deadline = batch[0].task.deadline;
+    for (auto& p : batch) {
+        priority = std::min(priority, p.task.priority);
+        deadline = (deadline == 0 || p.task.deadline == 0) ? 0 : std::max(deadline, p.task.deadline);
+        p.task.inputs.clear();
+        subs->push_back(std::move(p.task));
+    }
+
+    size_t max_batch = max_batch_;
+    Task merged{std::move(inputs), [subs, max_batch](std::vector<Tensor>&& outputs) {
+        auto& tasks = *subs;
+        size_t n = tasks.size();
+        std::vector<std::vector<Tensor>> results(n);
+        for (auto& out : outputs) {
+            size_t sample_size = out.size() / max_batch;
+            auto shape = out.shape();
+            if (!shape.empty() && shape[0] % max_batch == 0) {
+                shape[0] /= max_batch;
+            } else {
+                shape = {static_cast<uint32_t>(sample_size / out.getElementSize(out.dataType()))};
+            }
+            // 每个请求拿到的是batch输出的一段，共享内存不拷贝
+            for (size_t j = 0; j < n; j++) {
+                results[j].push_back(out.slice(j * sample_size, shape));
+            }
+        }
+        for (size_t j = 0; j < n; j++) {
+            tasks[j].cb(std::move(results[j]));
+        }
+    }};
+    merged.on_drop = [subs](TaskStatus status) {
+        for (auto& sub : *subs) {
+            sub.drop(status);
+        }
+    };
+    merged.priority = priority;
+    merged.deadline = deadline;
+    merged.times.enqueue = enqueue;
+    tq_->push(std::move(merged));
+}
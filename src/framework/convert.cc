@@ -0,0 +1,527 @@
+#include "convert.h"
+#include "tensor.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CONVERT_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define CONVERT_NEON 1
+#endif
+
+uint16_t floatToHalf(float value) {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    int32_t exp = ((x >> 23) & 0xff) - 127 + 15;
+    uint32_t mant = x & 0x7fffff;
+    if (((x >> 23) & 0xff) == 0xff) {
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+    }
+    if (exp >= 31) {
+        return sign | 0x7c00;
+    }
+    if (exp <= 0) {
+        if (exp < -10) {
+            return sign;
+        }
+        mant |= 0x800000;
+        uint32_t shift = 14 - exp;
+        uint32_t half = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t mid = 1u << (shift - 1);
+        if (rem > mid || (rem == mid && (half & 1))) {
+            half++;
+        }
+        return sign | half;
+    }
+    uint32_t half = sign | (exp << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1fff;
+    // 尾数进位可以直接进到指数上
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return half;
+}
+
+float halfToFloat(uint16_t value) {
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exp = (value >> 10) & 0x1f;
+    uint32_t mant = value & 0x3ff;
+    uint32_t x;
+    if (exp == 0x1f) {
+        x = sign | 0x7f800000 | (mant << 13);
+    } else if (exp != 0) {
+        x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+    } else if (mant == 0) {
+        x = sign;
+    } else {
+        // 非规格化数，规格化之后再拼
+        exp = 127 - 15 + 1;
+        while ((mant & 0x400) == 0) {
+            mant <<= 1;
+            exp--;
+        }
+        x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+    }
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+uint16_t floatToBf16(float value) {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    if ((x & 0x7fffffff) > 0x7f800000) {
+        // NaN保持为quiet NaN
+        return (x >> 16) | 0x40;
+    }
+    return (x + 0x7fff + ((x >> 16) & 1)) >> 16;
+}
+
+float bf16ToFloat(uint16_t value) {
+    uint32_t x = (uint32_t)value << 16;
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+namespace {
+
+template <typename T, int Lo, int Hi>
+inline T quantizeOne(float x, float inv_scale, int zero_point) {
+    // 先在float上截断，避免转int溢出
+    float v = std::nearbyint(x * inv_scale) + zero_point;
+    v = std::min(std::max(v, (float)Lo), (float)Hi);
+    return (T)v;
+}
+
+void floatToHalfScalar(const float* src, uint16_t* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = floatToHalf(src[i]);
+    }
+}
+
+void halfToFloatScalar(const uint16_t* src, float* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = halfToFloat(src[i]);
+    }
+}
+
+void floatToBf16Scalar(const float* src, uint16_t* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = floatToBf16(src[i]);
+    }
+}
+
+void bf16ToFloatScalar(const uint16_t* src, float* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = bf16ToFloat(src[i]);
+    }
+}
+
+void quantizeInt8Scalar(const float* src, int8_t* dst, size_t n, float inv_scale, int zp) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = quantizeOne<int8_t, -128, 127>(src[i], inv_scale, zp);
+    }
+}
+
+void dequantizeInt8Scalar(const int8_t* src, float* dst, size_t n, float scale, int zp) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = (float)(src[i] - zp) * scale;
+    }
+}
+
+void quantizeUint8Scalar(const float* src, uint8_t* dst, size_t n, float inv_scale, int zp) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = quantizeOne<uint8_t, 0, 255>(src[i], inv_scale, zp);
+    }
+}
+
+void dequantizeUint8Scalar(const uint8_t* src, float* dst, size_t n, float scale, int zp) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = (float)(src[i] - zp) * scale;
+    }
+}
+
+#if CONVERT_X86
+__attribute__((target("avx2,f16c")))
+void floatToHalfF16c(const float* src, uint16_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    floatToHalfScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2,f16c")))
+void halfToFloatF16c(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    halfToFloatScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void floatToBf16Avx2(const float* src, uint16_t* dst, size_t n) {
+    const __m256i bias = _mm256_set1_epi32(0x7fff);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i qnan = _mm256_set1_epi32(0x40);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i r[2];
+        for (int k = 0; k < 2; k++) {
+            __m256 v = _mm256_loadu_ps(src + i + k * 8);
+            __m256i x = _mm256_castps_si256(v);
+            __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+            __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_add_epi32(bias, lsb)), 16);
+            __m256i nan = _mm256_or_si256(_mm256_srli_epi32(x, 16), qnan);
+            __m256i is_nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+            r[k] = _mm256_blendv_epi8(rounded, nan, is_nan);
+        }
+        // packus按128位lane交错，再换回顺序
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(r[0], r[1]), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+    }
+    floatToBf16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void bf16ToFloatAvx2(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(x, 16)));
+    }
+    bf16ToFloatScalar(src + i, dst + i, n - i);
+}
+
+// 16个float量化后打包成16个int16，由调用方再压到8位
+__attribute__((target("avx2")))
+inline __m256i quantize16Avx2(const float* src, __m256 inv, __m256i zp, __m256 lo, __m256 hi) {
+    __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src), inv), lo), hi);
+    __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + 8), inv), lo), hi);
+    // cvtps_epi32默认就近取偶，与nearbyint一致
+    __m256i ia = _mm256_add_epi32(_mm256_cvtps_epi32(a), zp);
+    __m256i ib = _mm256_add_epi32(_mm256_cvtps_epi32(b), zp);
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xd8);
+}
+
+__attribute__((target("avx2")))
+void quantizeInt8Avx2(const float* src, int8_t* dst, size_t n, float inv_scale, int zero_point) {
+    const __m256 inv = _mm256_set1_ps(inv_scale);
+    const __m256i zp = _mm256_set1_epi32(zero_point);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i w = quantize16Avx2(src + i, inv, zp, lo, hi);
+        __m128i b = _mm_packs_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), b);
+    }
+    quantizeInt8Scalar(src + i, dst + i, n - i, inv_scale, zero_point);
+}
+
+__attribute__((target("avx2")))
+void quantizeUint8Avx2(const float* src, uint8_t* dst, size_t n, float inv_scale, int zero_point) {
+    const __m256 inv = _mm256_set1_ps(inv_scale);
+    const __m256i zp = _mm256_set1_epi32(zero_point);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i w = quantize16Avx2(src + i, inv, zp, lo, hi);
+        __m128i b = _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), b);
+    }
+    quantizeUint8Scalar(src + i, dst + i, n - i, inv_scale, zero_point);
+}
+
+__attribute__((target("avx2")))
+void dequantizeInt8Avx2(const int8_t* src, float* dst, size_t n, float scale, int zero_point) {
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256i zp = _mm256_set1_epi32(zero_point);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(x, zp)), vs));
+    }
+    dequantizeInt8Scalar(src + i, dst + i, n - i, scale, zero_point);
+}
+
+__attribute__((target("avx2")))
+void dequantizeUint8Avx2(const uint8_t* src, float* dst, size_t n, float scale, int zero_point) {
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256i zp = _mm256_set1_epi32(zero_point);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(x, zp)), vs));
+    }
+    dequantizeUint8Scalar(src + i, dst + i, n - i, scale, zero_point);
+}
+#endif
+
+#if CONVERT_NEON
+void floatToHalfNeon(const float* src, uint16_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    }
+    floatToHalfScalar(src + i, dst + i, n - i);
+}
+
+void halfToFloatNeon(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    }
+    halfToFloatScalar(src + i, dst + i, n - i);
+}
+
+void floatToBf16Neon(const float* src, uint16_t* dst, size_t n) {
+    const uint32x4_t bias = vdupq_n_u32(0x7fff);
+    const uint32x4_t one = vdupq_n_u32(1);
+    const uint32x4_t qnan = vdupq_n_u32(0x40);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(src + i);
+        uint32x4_t x = vreinterpretq_u32_f32(v);
+        uint32x4_t lsb = vandq_u32(vshrq_n_u32(x, 16), one);
+        uint32x4_t rounded = vshrq_n_u32(vaddq_u32(x, vaddq_u32(bias, lsb)), 16);
+        uint32x4_t nan = vorrq_u32(vshrq_n_u32(x, 16), qnan);
+        uint32x4_t not_nan = vceqq_f32(v, v);
+        vst1_u16(dst + i, vmovn_u32(vbslq_u32(not_nan, rounded, nan)));
+    }
+    floatToBf16Scalar(src + i, dst + i, n - i);
+}
+
+void bf16ToFloatNeon(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t x = vshll_n_u16(vld1_u16(src + i), 16);
+        vst1q_f32(dst + i, vreinterpretq_f32_u32(x));
+    }
+    bf16ToFloatScalar(src + i, dst + i, n - i);
+}
+
+inline int16x8_t quantize8Neon(const float* src, float32x4_t inv, int32x4_t zp) {
+    const float32x4_t lo = vdupq_n_f32(-32768.0f);
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+    float32x4_t a = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(src), inv), lo), hi);
+    float32x4_t b = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(src + 4), inv), lo), hi);
+    int32x4_t ia = vaddq_s32(vcvtnq_s32_f32(a), zp);
+    int32x4_t ib = vaddq_s32(vcvtnq_s32_f32(b), zp);
+    return vcombine_s16(vqmovn_s32(ia), vqmovn_s32(ib));
+}
+
+void quantizeInt8Neon(const float* src, int8_t* dst, size_t n, float inv_scale, int zero_point) {
+    const float32x4_t inv = vdupq_n_f32(inv_scale);
+    const int32x4_t zp = vdupq_n_s32(zero_point);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        vst1_s8(dst + i, vqmovn_s16(quantize8Neon(src + i, inv, zp)));
+    }
+    quantizeInt8Scalar(src + i, dst + i, n - i, inv_scale, zero_point);
+}
+
+void quantizeUint8Neon(const float* src, uint8_t* dst, size_t n, float inv_scale, int zero_point) {
+    const float32x4_t inv = vdupq_n_f32(inv_scale);
+    const int32x4_t zp = vdupq_n_s32(zero_point);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        vst1_u8(dst + i, vqmovun_s16(quantize8Neon(src + i, inv, zp)));
+    }
+    quantizeUint8Scalar(src + i, dst + i, n - i, inv_scale, zero_point);
+}
+
+void dequantizeInt8Neon(const int8_t* src, float* dst, size_t n, float scale, int zero_point) {
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const int32x4_t zp = vdupq_n_s32(zero_point);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x = vmovl_s8(vld1_s8(src + i));
+        int32x4_t a = vsubq_s32(vmovl_s16(vget_low_s16(x)), zp);
+        int32x4_t b = vsubq_s32(vmovl_s16(vget_high_s16(x)), zp);
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(a), vs));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(b), vs));
+    }
+    dequantizeInt8Scalar(src + i, dst + i, n - i, scale, zero_point);
+}
+
+void dequantizeUint8Neon(const uint8_t* src, float* dst, size_t n, float scale, int zero_point) {
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const int32x4_t zp = vdupq_n_s32(zero_point);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(src + i)));
+        int32x4_t a = vsubq_s32(vmovl_s16(vget_low_s16(x)), zp);
+        int32x4_t b = vsubq_s32(vmovl_s16(vget_high_s16(x)), zp);
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(a), vs));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(b), vs));
+    }
+    dequantizeUint8Scalar(src + i, dst + i, n - i, scale, zero_point);
+}
+#endif
+
+struct Kernels {
+    void (*f2h)(const float*, uint16_t*, size_t);
+    void (*h2f)(const uint16_t*, float*, size_t);
+    void (*f2bf)(const float*, uint16_t*, size_t);
+    void (*bf2f)(const uint16_t*, float*, size_t);
+    void (*quant_i8)(const float*, int8_t*, size_t, float, int);
+    void (*dequant_i8)(const int8_t*, float*, size_t, float, int);
+    void (*quant_u8)(const float*, uint8_t*, size_t, float, int);
+    void (*dequant_u8)(const uint8_t*, float*, size_t, float, int);
+    const char* name;
+};
+
+Kernels selectKernels() {
+#if CONVERT_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        return {floatToHalfF16c, halfToFloatF16c, floatToBf16Avx2, bf16ToFloatAvx2,
+                quantizeInt8Avx2, dequantizeInt8Avx2, quantizeUint8Avx2, dequantizeUint8Avx2, "f16c+avx2"};
+    }
+#elif CONVERT_NEON
+    return {floatToHalfNeon, halfToFloatNeon, floatToBf16Neon, bf16ToFloatNeon,
+            quantizeInt8Neon, dequantizeInt8Neon, quantizeUint8Neon, dequantizeUint8Neon, "neon"};
+#endif
+    return {floatToHalfScalar, halfToFloatScalar, floatToBf16Scalar, bf16ToFloatScalar,
+            quantizeInt8Scalar, dequantizeInt8Scalar, quantizeUint8Scalar, dequantizeUint8Scalar, "scalar"};
+}
+
+const Kernels& kernels() {
+    static const Kernels k = selectKernels();
+    return k;
+}
+
+bool isQuantized(DataType dtype) {
+    return dtype == INT8 || dtype == UINT8;
+}
+
+// 转成float32写到dst
+void toFloat(const void* src, DataType type, float* dst, size_t n, QuantParam q) {
+    switch (type) {
+        case FLOAT32: std::memcpy(dst, src, n * sizeof(float)); break;
+        case FLOAT16: kernels().h2f(static_cast<const uint16_t*>(src), dst, n); break;
+        case BFLOAT16: kernels().bf2f(static_cast<const uint16_t*>(src), dst, n); break;
+        case INT8: kernels().dequant_i8(static_cast<const int8_t*>(src), dst, n, q.scale, q.zero_point); break;
+        case UINT8: kernels().dequant_u8(static_cast<const uint8_t*>(src), dst, n, q.scale, q.zero_point); break;
+    }
+}
+
+void fromFloat(const float* src, void* dst, DataType type, size_t n, QuantParam q) {
+    float inv = 1.0f / q.scale;
+    switch (type) {
+        case FLOAT32: std::memcpy(dst, src, n * sizeof(float)); break;
+        case FLOAT16: kernels().f2h(src, static_cast<uint16_t*>(dst), n); break;
+        case BFLOAT16: kernels().f2bf(src, static_cast<uint16_t*>(dst), n); break;
+        case INT8: kernels().quant_i8(src, static_cast<int8_t*>(dst), n, inv, q.zero_point); break;
+        case UINT8: kernels().quant_u8(src, static_cast<uint8_t*>(dst), n, inv, q.zero_point); break;
+    }
+}
+
+size_t elementSize(DataType dtype) {
+    return dtype == FLOAT32 ? 4 : (dtype == FLOAT16 || dtype == BFLOAT16) ? 2 : 1;
+}
+
+}  // namespace
+
+const char* convertSimdName() {
+    return kernels().name;
+}
+
+void floatToHalf(const float* src, uint16_t* dst, size_t n) {
+    kernels().f2h(src, dst, n);
+}
+
+void halfToFloat(const uint16_t* src, float* dst, size_t n) {
+    kernels().h2f(src, dst, n);
+}
+
+void floatToBf16(const float* src, uint16_t* dst, size_t n) {
+    kernels().f2bf(src, dst, n);
+}
+
+void bf16ToFloat(const uint16_t* src, float* dst, size_t n) {
+    kernels().bf2f(src, dst, n);
+}
+
+void quantizeInt8(const float* src, int8_t* dst, size_t n, QuantParam q) {
+    kernels().quant_i8(src, dst, n, 1.0f / q.scale, q.zero_point);
+}
+
+void dequantizeInt8(const int8_t* src, float* dst, size_t n, QuantParam q) {
+    kernels().dequant_i8(src, dst, n, q.scale, q.zero_point);
+}
+
+void quantizeUint8(const float* src, uint8_t* dst, size_t n, QuantParam q) {
+    kernels().quant_u8(src, dst, n, 1.0f / q.scale, q.zero_point);
+}
+
+void dequantizeUint8(const uint8_t* src, float* dst, size_t n, QuantParam q) {
+    kernels().dequant_u8(src, dst, n, q.scale, q.zero_point);
+}
+
+void quantizeInt8PerChannel(const float* src, int8_t* dst, size_t channels, size_t inner,
+                            const QuantParam* params) {
+    for (size_t c = 0; c < channels; c++) {
+        quantizeInt8(src + c * inner, dst + c * inner, inner, params[c]);
+    }
+}
+
+void dequantizeInt8PerChannel(const int8_t* src, float* dst, size_t channels, size_t inner,
+                              const QuantParam* params) {
+    for (size_t c = 0; c < channels; c++) {
+        dequantizeInt8(src + c * inner, dst + c * inner, inner, params[c]);
+    }
+}
+
+Result convertBuffer(const void* src, DataType src_type, void* dst, DataType dst_type, size_t count,
+                     QuantParam q) {
+    if (isQuantized(src_type) || isQuantized(dst_type)) {
+        if (q.scale == 0.0f) {
+            ERROR_LOG("quant scale must not be zero");
+            return FAIL;
+        }
+    }
+    if (src_type == dst_type) {
+        std::memcpy(dst, src, count * elementSize(src_type));
+        return SUCCESS;
+    }
+    if (src_type == FLOAT32) {
+        fromFloat(static_cast<const float*>(src), dst, dst_type, count, q);
+        return SUCCESS;
+    }
+    if (dst_type == FLOAT32) {
+        toFloat(src, src_type, static_cast<float*>(dst), count, q);
+        return SUCCESS;
+    }
+    // 其它组合分块经float32中转，块放在栈上留在L1里
+    constexpr size_t kChunk = 1024;
+    float tmp[kChunk];
+    auto s = static_cast<const uint8_t*>(src);
+    auto d = static_cast<uint8_t*>(dst);
+    size_t s_elem = elementSize(src_type), d_elem = elementSize(dst_type);
+    for (size_t i = 0; i < count; i += kChunk) {
+        size_t n = std::min(kChunk, count - i);
+        toFloat(s + i * s_elem, src_type, tmp, n, q);
+        fromFloat(tmp, d + i * d_elem, dst_type, n, q);
+    }
+    return SUCCESS;
+}
+
+Tensor Tensor::convertTo(DataType dtype, QuantParam q) const {
+    if (dtype == datatype_) {
+        return *this;
+    }
+    Tensor t(shape_, dtype);
+    if (convertBuffer(data_, datatype_, t.data_, dtype, elementCount(), q) != SUCCESS) {
+        ERROR_LOG("convert tensor failed");
+    }
+    return t;
+}
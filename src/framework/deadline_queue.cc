@@ -0,0 +1,210 @@
+#include "deadline_queue.h"
+#include "work_stealing_queue.h"
+
+namespace {
+
+// 堆顶为key最小的元素
+struct Later {
+    template <typename T>
+    bool operator()(const T& a, const T& b) const {
+        return a.key != b.key ? a.key > b.key : a.seq > b.seq;
+    }
+};
+
+}  // namespace
+
+DeadlineQueue::DeadlineQueue(const SchedulerCfg& cfg)
+    : cfg_(cfg), aging_ns_((uint64_t)cfg.aging_ms * 1000000) {
+    cfg_.lanes = std::max(1, cfg_.lanes);
+    cfg_.capacity = std::max<size_t>(1, cfg_.capacity);
+    for (int i = 0; i < cfg_.lanes; i++) {
+        lanes_.push_back(std::make_unique<Lane>());
+    }
+}
+
+void DeadlineQueue::push(Task task) {
+    int index = std::min(std::max(task.priority, 0), cfg_.lanes - 1);
+    Lane* lane = lanes_[index].get();
+    uint64_t now = Profiler::now();
+    if (task.times.enqueue == 0) {
+        task.times.enqueue = now;
+    }
+    uint64_t enqueue = task.times.enqueue;
+    uint64_t deadline = task.deadline;
+    // 缩容用的空任务不计入统计
+    if (!task.retire) {
+        lane->submitted.fetch_add(1, std::memory_order_relaxed);
+        // 包一层回调做统计，原回调放在shared_ptr里，丢弃时也要用到
+        auto cb = std::make_shared<TaskCallback>(std::move(task.cb));
+        task.cb = [cb, lane, enqueue, deadline](std::vector<Tensor>&& outputs) {
+            uint64_t end = Profiler::now();
+            lane->latency.record(end - enqueue);
+            lane->completed.fetch_add(1, std::memory_order_relaxed);
+            if (deadline != 0 && end > deadline) {
+                lane->missed.fetch_add(1, std::memory_order_relaxed);
+            }
+            (*cb)(std::move(outputs));
+        };
+        task.on_drop = [cb, lane, on_drop = std::move(task.on_drop)](TaskStatus status) {
+            (status == TASK_EXPIRED ? lane->expired : lane->failed).fetch_add(1, std::memory_order_relaxed);
+            if (on_drop) {
+                on_drop(status);
+            } else if (*cb) {
+                (*cb)({});
+            }
+        };
+    }
+
+    // 没有deadline的任务按等待aging_ms计算，不会被有deadline的任务无限插队
+    uint64_t key = deadline != 0 ? deadline : (aging_ns_ > 0 ? enqueue + aging_ns_ : UINT64_MAX);
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        not_full_.wait(lock, [this] { return size_ < cfg_.capacity; });
+        lane->heap.push_back({std::move(task), key, seq_++});
+        std::push_heap(lane->heap.begin(), lane->heap.end(), Later{});
+        size_++;
+    }
+    not_empty_.notify_one();
+}
+
+bool DeadlineQueue::pop(Task& task_out) {
+    std::vector<Task> expired;
+    bool got = false;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true) {
+            not_empty_.wait(lock, [this] { return stop_ || size_ > 0; });
+            uint64_t now = Profiler::now();
+            collectExpired(now, expired);
+            int lane = pickLane(now);
+            if (lane >= 0) {
+                task_out = std::move(popLane(lane).task);
+                got = true;
+                break;
+            }
+            if (stop_) {
+                break;
+            }
+            // 只取到了过期任务，先在锁外丢弃再继续等
+            if (!expired.empty()) {
+                break;
+            }
+        }
+    }
+    if (!expired.empty()) {
+        not_full_.notify_all();
+        for (auto& task : expired) {
+            task.drop(TASK_EXPIRED);
+        }
+        if (!got) {
+            return pop(task_out);
+        }
+    }
+    if (got) {
+        not_full_.notify_one();
+        return true;
+    }
+    INFO_LOG("DeadlineQueue stopped");
+    return false;
+}
+
+void DeadlineQueue::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+size_t DeadlineQueue::size() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return size_;
+}
+
+int DeadlineQueue::pickLane(uint64_t now) const {
+    // 低优先级通道的队头等太久时先服务等得最久的那个
+    if (aging_ns_ > 0) {
+        int aged = -1;
+        uint64_t oldest = UINT64_MAX;
+        for (int i = 1; i < cfg_.lanes; i++) {
+            auto& heap = lanes_[i]->heap;
+            if (heap.empty()) {
+                continue;
+            }
+            uint64_t enqueue = heap.front().task.times.enqueue;
+            if (now - enqueue > aging_ns_ && enqueue < oldest) {
+                aged = i;
+                oldest = enqueue;
+            }
+        }
+        if (aged >= 0) {
+            return aged;
+        }
+    }
+    for (int i = 0; i < cfg_.lanes; i++) {
+        if (!lanes_[i]->heap.empty()) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void DeadlineQueue::collectExpired(uint64_t now, std::vector<Task>& expired) {
+    for (int i = 0; i < cfg_.lanes; i++) {
+        auto& heap = lanes_[i]->heap;
+        while (!heap.empty() && heap.front().task.expired(now)) {
+            expired.push_back(std::move(popLane(i).task));
+        }
+    }
+}
+
+DeadlineQueue::Item DeadlineQueue::popLane(int lane) {
+    auto& heap = lanes_[lane]->heap;
+    std::pop_heap(heap.begin(), heap.end(), Later{});
+    Item item = std::move(heap.back());
+    heap.pop_back();
+    size_--;
+    return item;
+}
+
+std::string DeadlineQueue::toJson() const {
+    std::string out = "{\"policy\":\"edf\",\"aging_ms\":" + std::to_string(cfg_.aging_ms) + ",\"lanes\":[";
+    char buf[512];
+    for (int i = 0; i < cfg_.lanes; i++) {
+        auto& lane = *lanes_[i];
+        auto& h = lane.latency;
+        snprintf(buf, sizeof(buf),
+                 "%s{\"priority\":%d,\"submitted\":%lu,\"completed\":%lu,\"missed\":%lu,\"expired\":%lu,"
+                 "\"failed\":%lu,\"latency_us\":{\"mean\":%.1f,\"p50\":%.1f,\"p99\":%.1f,\"max\":%.1f}}",
+                 i == 0 ? "" : ",", i, lane.submitted.load(), lane.completed.load(), lane.missed.load(),
+                 lane.expired.load(), lane.failed.load(), h.mean() / 1e3, h.percentile(50) / 1e3,
+                 h.percentile(99) / 1e3, h.max() / 1e3);
+        out += buf;
+    }
+    out += "]}\n";
+    return out;
+}
+
+void DeadlineQueue::logStats() const {
+    for (int i = 0; i < cfg_.lanes; i++) {
+        auto& lane = *lanes_[i];
+        INFO_LOG("Lane[%d]: submitted %lu, completed %lu (missed deadline %lu), expired %lu, failed %lu, "
+                 "p50 %.1f us, p99 %.1f us",
+                 i, lane.submitted.load(), lane.completed.load(), lane.missed.load(), lane.expired.load(),
+                 lane.failed.load(), lane.latency.percentile(50) / 1e3, lane.latency.percentile(99) / 1e3);
+    }
+}
+
+std::unique_ptr<TaskQueue> makeTaskQueue(const SchedulerCfg& cfg, int num_workers) {
+    if (cfg.policy == "edf") {
+        return std::make_unique<DeadlineQueue>(cfg);
+    }
+    if (cfg.policy == "steal") {
+        return std::make_unique<WorkStealingQueue>(num_workers, cfg.capacity);
+    }
+    if (cfg.policy != "fifo") {
+        WARN_LOG("unknown scheduler policy %s, use fifo", cfg.policy.c_str());
+    }
+    return std::make_unique<FifoTaskQueue>(cfg.capacity);
+}
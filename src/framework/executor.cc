@@ -2,12 +2,15 @@
 
 // 要保证调用构造函数时，backend_type一定是合法的
 // 入参的backend指针代表该执行器在这个后端上运行
-Executor::Executor(const std::string& model_path, Backend* backend, TaskQueue* tq, int id, DataType otype) 
+Executor::Executor(const std::string& model_path, Backend* backend, TaskQueue* tq, int id, DataType otype,
+                   int pipeline_depth, Profiler* profiler)
     : backend_(backend)
     , model_path_(model_path)
     , tq_(tq)
     , id_(id)
-    , output_type_(otype) {
+    , output_type_(otype)
+    , pipeline_depth_(pipeline_depth)
+    , profiler_(profiler) {
         INFO_LOG("executor[%d] created!", id_);
     }
 
@@ -20,45 +23,150 @@ Result Executor::Execute() {
     RETURN_IF_ERR(init(), "Executor init fail");
     INFO_LOG("Executor[%d] loadModel", id_);
     RETURN_IF_ERR(loadModel(), "Exeuctor load model fail");
+    if (governor_) {
+        governor_->attach(backend_, std::max(1, pipeline_depth_));
+    }
+    if (pipeline_depth_ > 1) {
+        // 失败也要先归还governor名额、模型和stream再返回
+        Result ret = executePipelined();
+        if (ret != SUCCESS) {
+            ERROR_LOG("Executor[%d] pipelined execute fail", id_);
+        }
+        if (governor_) {
+            governor_->detach(backend_, pipeline_depth_);
+        }
+        RETURN_IF_ERR(unloadModel(), "Executor unload model fail");
+        RETURN_IF_ERR(finalize(), "Executor finalize fail");
+        return ret;
+    }
     Task task{};
-    while (tq_->pop(task)) {
-        // 分配设备内存
-        INFO_LOG("Executor[%d] PrepareInput", id_);
-        RETURN_IF_ERR(prepareInput(std::move(task.inputs)), "Executor failed to prepare input");
-        INFO_LOG("Executor[%d] PrepareOutput", id_);
-        RETURN_IF_ERR(prepareOutput(), "Executor fail to prepare output");
+    while (nextTask(task)) {
+        if (task.retire) {
+            INFO_LOG("Executor[%d] retired", id_);
+            retired_ = true;
+            taskFinished();
+            break;
+        }
+        uint64_t begin = Profiler::now();
+        auto& times = task.times;
+        if (profiler_) {
+            times.dequeue = times.h2d_begin = Profiler::now();
+        }
+        // 排队期间已经超时的任务不再上设备
+        if (task.deadline != 0 && task.expired(Profiler::now())) {
+            task.drop(TASK_EXPIRED);
+            taskFinished();
+            continue;
+        }
+        if (switchModel(task.model.empty() ? model_path_ : task.model) != SUCCESS) {
+            task.drop(TASK_FAILED);
+            taskFinished();
+            continue;
+        }
+        // 分配设备内存；输入不合法或设备出错只丢弃这一个任务，executor继续服务
+        DEBUG_LOG("Executor[%d] PrepareInput", id_);
+        if (prepareInput(std::move(task.inputs)) != SUCCESS || prepareOutput() != SUCCESS) {
+            ERROR_LOG("Executor[%d] failed to prepare buffers, task dropped", id_);
+            destroyBuffers();
+            task.drop(TASK_FAILED);
+            taskFinished();
+            continue;
+        }
+        if (profiler_) {
+            times.h2d_end = Profiler::now();
+        }
         // 执行
-        INFO_LOG("Executor[%d] Run", id_);
-        RETURN_IF_ERR(run(), "Executor run fail");
+        DEBUG_LOG("Executor[%d] Run", id_);
+        if (run() != SUCCESS) {
+            ERROR_LOG("Executor[%d] run fail, task dropped", id_);
+            destroyBuffers();
+            task.drop(TASK_FAILED);
+            taskFinished();
+            continue;
+        }
+        if (profiler_) {
+            times.infer_end = Profiler::now();
+        }
         // 回调函数将结果传输至session
-        INFO_LOG("Executor[%d] GetOutput", id_);
-        task.cb(getOutput());
-        // 释放设备内存
+        DEBUG_LOG("Executor[%d] GetOutput", id_);
+        auto outputs = getOutput();
+        if (profiler_) {
+            times.d2h_end = Profiler::now();
+        }
+        task.cb(std::move(outputs));
+        if (profiler_) {
+            times.cb_end = Profiler::now();
+            profiler_->record(id_, times);
+        }
+        // 设备内存还给内存池
         destroyBuffers();
+        busy_ns_.fetch_add(Profiler::now() - begin, std::memory_order_relaxed);
+        tasks_done_.fetch_add(1, std::memory_order_relaxed);
+        taskFinished();
+    }
+    if (governor_) {
+        governor_->detach(backend_, 1);
     }
     RETURN_IF_ERR(unloadModel(), "Executor unload model fail");
     RETURN_IF_ERR(finalize(), "Executor finalize fail");
     return SUCCESS;
 }
 
+bool Executor::nextTask(Task& task) {
+    if (governor_) {
+        governor_->acquire(backend_);
+    }
+    if (!tq_->pop(task, id_)) {
+        taskFinished();
+        return false;
+    }
+    return true;
+}
+
+uint64_t Executor::busyNs() const {
+    // releaseSlot先累加再清busy_since_，两次读到的busy_ns_相同说明中间没有结束一段忙碌
+    while (true) {
+        uint64_t busy = busy_ns_.load();
+        uint64_t since = busy_since_.load();
+        if (busy_ns_.load() == busy) {
+            uint64_t now = Profiler::now();
+            return busy + (since != 0 && now > since ? now - since : 0);
+        }
+    }
+}
+
+void Executor::taskFinished() {
+    if (governor_) {
+        governor_->release(backend_);
+    }
+}
+
 // 这里的初始化为在后端上初始化运行时资源
 Result Executor::init() {
+    RETURN_IF_ERR(backend_->bindThread(), "Executor bind device fail");
     stream_ = backend_->createStream();
     if (stream_->getStream() == nullptr) {
         ERROR_LOG("IT'S NULL PTR!!!!!!!!!!!!!!!!!!");
         return FAIL;
     }
+    // 输入输出各占一个块
+    pool_cache_ = std::make_unique<PoolCache>(backend_->getMemoryPool(), 2);
     return SUCCESS;
 }
 
 Result Executor::finalize() {
+    // 本地缓存的块归还给backend的内存池，供其他executor复用
+    pool_cache_.reset();
     return backend_->destoryStream(stream_.get());
 }
 
 Result Executor::loadModel() {
-    model_id_ = backend_->loadModel(model_path_);
-    assert(model_id_ != -1);
-    info_ = backend_->getModelInfo(model_id_);
+    model_ = manager_ ? manager_->get(model_path_) : backend_->acquireModel(model_path_);
+    if (!model_) {
+        ERROR_LOG("执行器加载模型%s失败", model_path_.c_str());
+        return FAIL;
+    }
+    info_ = model_->getInfo();
     if (!info_) {
         ERROR_LOG("执行器获取ModelInfo失败");
         return FAIL;
@@ -66,13 +174,66 @@ Result Executor::loadModel() {
     return SUCCESS;
 }
 
+// 只释放本executor的引用，最后一个引用释放时才真正卸载
 Result Executor::unloadModel() {
-    assert(model_id_ != -1);
-    return backend_->unloadModel(model_path_);
+    info_ = nullptr;
+    model_.reset();
+    return SUCCESS;
 }
 
-// 在设备上分配内存并转移数据
-Result Executor::prepareInput(std::vector<Tensor>&& inputs) {
+Result Executor::switchModel(const std::string& path) {
+    if (path == model_->getPath()) {
+        return SUCCESS;
+    }
+    auto handle = manager_ ? manager_->get(path) : backend_->acquireModel(path);
+    if (!handle) {
+        ERROR_LOG("Executor[%d] failed to load model %s", id_, path.c_str());
+        return FAIL;
+    }
+    DEBUG_LOG("Executor[%d] switch model %s -> %s", id_, model_->getPath().c_str(), path.c_str());
+    if (slots_.empty()) {
+        model_ = std::move(handle);
+        info_ = model_->getInfo();
+        return SUCCESS;
+    }
+    {
+        std::unique_lock<std::mutex> lock(slot_lock_);
+        waitSlotsIdle(lock);
+    }
+    // 先分配好新模型的slot内存再释放旧的，分配失败时保持原模型和原内存，executor还能继续服务
+    auto info = handle->getInfo();
+    size_t input_size = info->getBatchSize() * info->getInputSize();
+    size_t output_size = info->getBatchSize() * info->getOutputSize();
+    auto pool = backend_->getMemoryPool();
+    std::vector<std::pair<void*, void*>> buffers;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        void* in = pool->acquire(input_size);
+        void* out = pool->acquire(output_size);
+        if (in == nullptr || out == nullptr) {
+            ERROR_LOG("Executor[%d] failed to acquire slot buffers for model %s", id_, path.c_str());
+            pool->release(in, input_size);
+            pool->release(out, output_size);
+            for (auto& [bin, bout] : buffers) {
+                pool->release(bin, input_size);
+                pool->release(bout, output_size);
+            }
+            return FAIL;
+        }
+        buffers.emplace_back(in, out);
+    }
+    releaseSlotBuffers();
+    for (size_t i = 0; i < slots_.size(); i++) {
+        slots_[i].dev_input_ptr = buffers[i].first;
+        slots_[i].dev_output_ptr = buffers[i].second;
+    }
+    dev_input_size_ = input_size;
+    dev_output_size_ = output_size;
+    model_ = std::move(handle);
+    info_ = info;
+    return SUCCESS;
+}
+
+Result Executor::checkInput(const std::vector<Tensor>& inputs) {
     assert(info_ != nullptr);
 
     size_t inum = inputs.size(), mnum = info_->getInputNum();
@@ -92,9 +253,19 @@ Result Executor::prepareInput(std::vector<Tensor>&& inputs) {
                     input_size, model_input_size);
         return FAIL;
     }
+    return SUCCESS;
+}
 
-    backend_->malloc((void**)&dev_input_ptr_, input_size);
-    assert(dev_input_ptr_ != nullptr);
+// 在设备上分配内存并转移数据
+Result Executor::prepareInput(std::vector<Tensor>&& inputs) {
+    RETURN_IF_ERR(checkInput(inputs), "Executor input check fail");
+    size_t input_size = info_->getBatchSize() * info_->getInputSize();
+    dev_input_ptr_ = pool_cache_->acquire(input_size);
+    if (dev_input_ptr_ == nullptr) {
+        ERROR_LOG("Executor[%d] failed to acquire %zu bytes input buffer", id_, input_size);
+        return FAIL;
+    }
+    dev_input_size_ = input_size;
     auto temp = static_cast<char*>(dev_input_ptr_);
     for (auto& tensor : inputs) {
         auto size = tensor.size();
@@ -107,32 +278,59 @@ Result Executor::prepareInput(std::vector<Tensor>&& inputs) {
 
 Result Executor::prepareOutput() {
     size_t model_output_size = info_->getBatchSize() * info_->getOutputSize();
-    backend_->malloc((void**)&dev_output_ptr_, model_output_size);
-    assert(dev_output_ptr_ != nullptr);
+    dev_output_ptr_ = pool_cache_->acquire(model_output_size);
+    if (dev_output_ptr_ == nullptr) {
+        ERROR_LOG("Executor[%d] failed to acquire %zu bytes output buffer", id_, model_output_size);
+        return FAIL;
+    }
+    dev_output_size_ = model_output_size;
     return SUCCESS;
 }
 
 // 同步接口
 Result Executor::run() {
-    return backend_->infer(stream_.get(), model_id_, dev_input_ptr_, dev_output_ptr_);
+    return backend_->infer(stream_.get(), model_.get(), dev_input_ptr_, dev_output_ptr_);
 }
 
-// 将输出数据搬回主机
-std::vector<Tensor> Executor::getOutput() {
+std::vector<Tensor> Executor::allocOutputs() {
     auto output_num = info_->getOutputNum();
-    auto output_size = info_->getOutputSize();
     std::vector<Tensor> outputs;
     outputs.reserve(output_num);
 
-    auto shapes = info_->getOutputsShape();
+    auto& shapes = info_->getOutputsShape();
     assert(shapes.size() == output_num);
+    auto batch = info_->getBatchSize();
+    for (int i = 0; i < output_num; i++) {
+        // ModelInfo中的shape是单个样本的，batch>1时输出张量要放下整个batch
+        auto shape = shapes[i];
+        if (batch > 1 && !shape.empty()) {
+            shape[0] *= batch;
+        }
+        // 输出直接放在后端的主机内存池里，张量交给调用方后最后一个引用释放时归还
+        size_t bytes = batch * info_->getOutputSize();
+        auto host_pool = backend_->getHostMemoryPool();
+        void* host_ptr = host_pool->acquire(bytes);
+        if (host_ptr == nullptr) {
+            outputs.emplace_back(shape, output_type_);
+        } else {
+            outputs.emplace_back(host_ptr, shape, output_type_, [host_pool, bytes](void* ptr) {
+                host_pool->release(ptr, bytes);
+            });
+        }
+        assert(outputs.back().size() == bytes);
+    }
+    return outputs;
+}
+
+// 将输出数据搬回主机
+std::vector<Tensor> Executor::getOutput() {
+    std::vector<Tensor> outputs = allocOutputs();
 
     auto dev_out_ptr = static_cast<const char*>(dev_output_ptr_);
-    for (int i = 0; i < output_num; i++) {
-        outputs.emplace_back(shapes[i], output_type_);
-        Tensor& tensor = outputs.back();
-        assert(tensor.size() == output_size);
+    for (int i = 0; i < outputs.size(); i++) {
+        Tensor& tensor = outputs[i];
         assert(tensor.data() != nullptr);
+        auto output_size = tensor.size();
         auto err = backend_->memcopy(
             tensor.data(),
             dev_out_ptr + i * output_size,
@@ -154,6 +352,253 @@ std::vector<Tensor> Executor::getOutput() {
 }
 
 void Executor::destroyBuffers() {
-    backend_->free(dev_input_ptr_);
-    backend_->free(dev_output_ptr_);
+    pool_cache_->release(dev_input_ptr_, dev_input_size_);
+    pool_cache_->release(dev_output_ptr_, dev_output_size_);
+    dev_input_ptr_ = nullptr;
+    dev_output_ptr_ = nullptr;
+}
+
+// 流水线执行：最多pipeline_depth_个任务同时在途
+// 任务i的推理可以和任务i+1的H2D、任务i-1的D2H重叠
+// 无论从哪里退出，都先等在途slot的回调全部完成再释放流水线资源，回调里引用了slot和this
+Result Executor::executePipelined() {
+    if (initPipeline() != SUCCESS) {
+        ERROR_LOG("Executor[%d] init pipeline fail", id_);
+        finalizePipeline();
+        return FAIL;
+    }
+    Task task{};
+    while (nextTask(task)) {
+        if (task.retire) {
+            INFO_LOG("Executor[%d] retired", id_);
+            retired_ = true;
+            taskFinished();
+            break;
+        }
+        if (profiler_) {
+            task.times.dequeue = Profiler::now();
+        }
+        if (switchModel(task.model.empty() ? model_path_ : task.model) != SUCCESS) {
+            task.drop(TASK_FAILED);
+            taskFinished();
+            continue;
+        }
+        if (checkInput(task.inputs) != SUCCESS) {
+            task.drop(TASK_FAILED);
+            taskFinished();
+            continue;
+        }
+        Slot& slot = acquireSlot();
+        // 等slot期间可能已经超时
+        if (task.deadline != 0 && task.expired(Profiler::now())) {
+            releaseSlot(slot);
+            task.drop(TASK_EXPIRED);
+            continue;
+        }
+        slot.task = std::move(task);
+        // 提交到一半失败时，已入队的H2D还在读输入张量、D2H还在写主机输出缓冲，
+        // 先等三个stream和这个slot的回调都结束，再丢弃任务、归还slot(会释放这些内存)
+        if (submitSlot(slot) != SUCCESS) {
+            ERROR_LOG("Executor[%d] failed to submit slot", id_);
+            synchronizeStreams();
+            {
+                std::unique_lock<std::mutex> lock(slot_lock_);
+                slot_cond_.wait(lock, [&slot] { return slot.callbacks == 0; });
+            }
+            slot.task.drop(TASK_FAILED);
+            releaseSlot(slot);
+        }
+    }
+    {
+        std::unique_lock<std::mutex> lock(slot_lock_);
+        waitSlotsIdle(lock);
+    }
+    return finalizePipeline();
+}
+
+Result Executor::initPipeline() {
+    h2d_stream_ = backend_->createStream();
+    d2h_stream_ = backend_->createStream();
+    if (h2d_stream_->getStream() == nullptr || d2h_stream_->getStream() == nullptr) {
+        ERROR_LOG("Executor[%d] failed to create pipeline streams", id_);
+        return FAIL;
+    }
+
+    // Slot含有原子变量不能移动，直接构造
+    slots_ = std::vector<Slot>(pipeline_depth_);
+    for (auto& slot : slots_) {
+        slot.h2d_done = backend_->createEvent();
+        slot.infer_done = backend_->createEvent();
+    }
+    RETURN_IF_ERR(acquireSlotBuffers(), "Executor acquire slot buffers fail");
+    INFO_LOG("Executor[%d] pipeline ready, depth = %d", id_, pipeline_depth_);
+    return SUCCESS;
+}
+
+// slot的设备内存在同一个模型的整个执行期间复用
+Result Executor::acquireSlotBuffers() {
+    dev_input_size_ = info_->getBatchSize() * info_->getInputSize();
+    dev_output_size_ = info_->getBatchSize() * info_->getOutputSize();
+    auto pool = backend_->getMemoryPool();
+    for (auto& slot : slots_) {
+        slot.dev_input_ptr = pool->acquire(dev_input_size_);
+        slot.dev_output_ptr = pool->acquire(dev_output_size_);
+        if (slot.dev_input_ptr == nullptr || slot.dev_output_ptr == nullptr) {
+            ERROR_LOG("Executor[%d] failed to acquire slot buffers", id_);
+            return FAIL;
+        }
+    }
+    return SUCCESS;
+}
+
+void Executor::releaseSlotBuffers() {
+    auto pool = backend_->getMemoryPool();
+    for (auto& slot : slots_) {
+        pool->release(slot.dev_input_ptr, dev_input_size_);
+        pool->release(slot.dev_output_ptr, dev_output_size_);
+        slot.dev_input_ptr = nullptr;
+        slot.dev_output_ptr = nullptr;
+    }
+}
+
+void Executor::synchronizeStreams() {
+    for (auto stream : {h2d_stream_.get(), stream_.get(), d2h_stream_.get()}) {
+        if (stream != nullptr) {
+            stream->synchronize();
+        }
+    }
+}
+
+Result Executor::finalizePipeline() {
+    // 先等stream上的操作执行完；回调可能是异步的，再等回调计数归零
+    synchronizeStreams();
+    {
+        std::unique_lock<std::mutex> lock(slot_lock_);
+        waitSlotsIdle(lock);
+    }
+    releaseSlotBuffers();
+    for (auto& slot : slots_) {
+        backend_->destoryEvent(slot.h2d_done.get());
+        backend_->destoryEvent(slot.infer_done.get());
+    }
+    slots_.clear();
+    RETURN_IF_ERR(backend_->destoryStream(h2d_stream_.get()), "Executor destory h2d stream fail");
+    RETURN_IF_ERR(backend_->destoryStream(d2h_stream_.get()), "Executor destory d2h stream fail");
+    return SUCCESS;
+}
+
+Result Executor::submitSlot(Slot& slot) {
+    if (profiler_) {
+        slot.task.times.h2d_begin = Profiler::now();
+        slot.h2d_end.store(0, std::memory_order_relaxed);
+        slot.infer_end.store(0, std::memory_order_relaxed);
+    }
+    // H2D
+    auto dev_in = static_cast<char*>(slot.dev_input_ptr);
+    for (auto& tensor : slot.task.inputs) {
+        RETURN_IF_ERR(backend_->memcopyAsync(h2d_stream_.get(), dev_in, tensor.data(), tensor.size(), HOST2DEVICE),
+                      "Executor H2D copy fail");
+        dev_in += tensor.size();
+    }
+    RETURN_IF_ERR(h2d_stream_->recordEvent(slot.h2d_done.get()), "Executor record h2d event fail");
+    if (profiler_) {
+        RETURN_IF_ERR(addSlotCallback(h2d_stream_.get(), slot,
+                                      [&slot]() { slot.h2d_end.store(Profiler::now(), std::memory_order_relaxed); }),
+                      "Executor add h2d callback fail");
+    }
+
+    // 推理，等H2D完成
+    RETURN_IF_ERR(stream_->waitEvent(slot.h2d_done.get()), "Executor wait h2d event fail");
+    RETURN_IF_ERR(backend_->inferAsync(stream_.get(), model_.get(), slot.dev_input_ptr, slot.dev_output_ptr),
+                  "Executor infer fail");
+    RETURN_IF_ERR(stream_->recordEvent(slot.infer_done.get()), "Executor record infer event fail");
+    if (profiler_) {
+        RETURN_IF_ERR(addSlotCallback(stream_.get(), slot,
+                                      [&slot]() { slot.infer_end.store(Profiler::now(), std::memory_order_relaxed); }),
+                      "Executor add infer callback fail");
+    }
+
+    // D2H，等推理完成
+    RETURN_IF_ERR(d2h_stream_->waitEvent(slot.infer_done.get()), "Executor wait infer event fail");
+    slot.outputs = allocOutputs();
+    auto dev_out = static_cast<const char*>(slot.dev_output_ptr);
+    for (int i = 0; i < slot.outputs.size(); i++) {
+        auto output_size = slot.outputs[i].size();
+        RETURN_IF_ERR(backend_->memcopyAsync(d2h_stream_.get(), slot.outputs[i].data(), dev_out + i * output_size,
+                                             output_size, DEVICE2HOST),
+                      "Executor D2H copy fail");
+    }
+
+    // 回调在D2H完成后执行
+    return addSlotCallback(d2h_stream_.get(), slot, [this, &slot]() {
+        auto& times = slot.task.times;
+        if (profiler_) {
+            times.d2h_end = Profiler::now();
+            times.h2d_end = slot.h2d_end.load(std::memory_order_relaxed);
+            times.infer_end = slot.infer_end.load(std::memory_order_relaxed);
+        }
+        slot.task.cb(std::move(slot.outputs));
+        if (profiler_) {
+            times.cb_end = Profiler::now();
+            profiler_->record(id_, times);
+        }
+        tasks_done_.fetch_add(1, std::memory_order_relaxed);
+        releaseSlot(slot);
+    });
+}
+
+Result Executor::addSlotCallback(Stream* stream, Slot& slot, std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(slot_lock_);
+        slot.callbacks++;
+    }
+    auto done = [this, &slot]() {
+        {
+            std::lock_guard<std::mutex> lock(slot_lock_);
+            slot.callbacks--;
+        }
+        slot_cond_.notify_all();
+    };
+    auto res = stream->addCallback([fn = std::move(fn), done]() {
+        fn();
+        done();
+    });
+    if (res != SUCCESS) {
+        done();
+    }
+    return res;
+}
+
+void Executor::waitSlotsIdle(std::unique_lock<std::mutex>& lock) {
+    slot_cond_.wait(lock, [this] {
+        return std::none_of(slots_.begin(), slots_.end(), [](const Slot& s) { return s.busy || s.callbacks > 0; });
+    });
+}
+
+Executor::Slot& Executor::acquireSlot() {
+    std::unique_lock<std::mutex> lock(slot_lock_);
+    // 回调按提交顺序完成，所以轮转到的slot总是最早提交的那个
+    Slot& slot = slots_[next_slot_];
+    slot_cond_.wait(lock, [&slot] { return !slot.busy && slot.callbacks == 0; });
+    slot.busy = true;
+    if (active_slots_++ == 0) {
+        busy_since_ = Profiler::now();
+    }
+    next_slot_ = (next_slot_ + 1) % slots_.size();
+    return slot;
+}
+
+void Executor::releaseSlot(Slot& slot) {
+    {
+        std::lock_guard<std::mutex> lock(slot_lock_);
+        slot.task = Task{};
+        slot.outputs.clear();
+        slot.busy = false;
+        if (--active_slots_ == 0) {
+            busy_ns_.fetch_add(Profiler::now() - busy_since_.load());
+            busy_since_.store(0);
+        }
+    }
+    slot_cond_.notify_all();
+    taskFinished();
 }
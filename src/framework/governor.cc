@@ -0,0 +1,267 @@
+#include "governor.h"
+#include "monitor.h"
+#include "affinity.h"
+#include "profiler.h"
+
+static const char* levelName(ThrottleLevel level) {
+    static const char* names[] = {"none", "soft", "hard"};
+    return names[level];
+}
+
+Governor::Governor(const GovernorCfg& cfg) : cfg_(cfg) {
+    cfg_.interval_ms = std::max<uint32_t>(1, cfg_.interval_ms);
+    cfg_.min_depth = std::max(1, cfg_.min_depth);
+    auto telemetry = Telemetry::getInstance();
+    telemetry->describe("infer_governor_level", METRIC_GAUGE, "Throttle level: 0 none, 1 soft, 2 hard");
+    telemetry->describe("infer_governor_depth_limit", METRIC_GAUGE, "In-flight task limit, -1 unlimited");
+    collector_id_ = telemetry->addCollector([this](const Telemetry::Emit& emit) {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto& [backend, dev] : devices_) {
+            MetricLabels labels{{"device", dev.name}};
+            emit("infer_governor_level", labels, dev.level);
+            emit("infer_governor_depth_limit", labels, dev.limit);
+        }
+    });
+}
+
+Governor::~Governor() {
+    stop();
+    Telemetry::getInstance()->removeCollector(collector_id_);
+}
+
+void Governor::start() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = false;
+    }
+    evaluate();
+    worker_ = std::thread(&Governor::loop, this);
+    INFO_LOG("Governor started, temperature margin %d/%d, memory %.2f/%.2f, every %u ms", cfg_.temp_margin,
+             cfg_.temp_critical, cfg_.mem_high, cfg_.mem_critical, cfg_.interval_ms);
+}
+
+void Governor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (stop_) {
+            return;
+        }
+        stop_ = true;
+        // 结算限流时间
+        uint64_t now = Profiler::now();
+        for (auto& [backend, dev] : devices_) {
+            if (dev.level != THROTTLE_NONE) {
+                dev.throttled_ns += now - dev.level_since;
+                dev.level_since = now;
+            }
+        }
+    }
+    cond_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void Governor::loop() {
+    setThreadName("governor");
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!cond_.wait_for(lock, std::chrono::milliseconds(cfg_.interval_ms), [this] { return stop_; })) {
+        lock.unlock();
+        evaluate();
+        lock.lock();
+    }
+}
+
+Governor::Device& Governor::device(Backend* backend) {
+    auto it = devices_.find(backend);
+    if (it == devices_.end()) {
+        it = devices_.emplace(backend, Device{}).first;
+        it->second.name = deviceLabel(backend->getBackendType(), backend->getDeviceId());
+    }
+    return it->second;
+}
+
+ThrottleLevel Governor::classify(ThrottleLevel current, int32_t headroom, double memory_rate) const {
+    auto raw = [this, headroom, memory_rate](int32_t temp_slack, double mem_slack) {
+        if (headroom <= cfg_.temp_critical + temp_slack || memory_rate >= cfg_.mem_critical - mem_slack) {
+            return THROTTLE_HARD;
+        }
+        if (headroom <= cfg_.temp_margin + temp_slack || memory_rate >= cfg_.mem_high - mem_slack) {
+            return THROTTLE_SOFT;
+        }
+        return THROTTLE_NONE;
+    };
+    ThrottleLevel level = raw(0, 0.0);
+    if (level >= current) {
+        return level;
+    }
+    // 降级要越过阈值再多退一段
+    return std::min(current, raw(cfg_.temp_hysteresis, cfg_.mem_hysteresis));
+}
+
+void Governor::evaluate() {
+    struct Reading {
+        Backend* backend;
+        int32_t temperature;
+        int32_t limit;
+        double memory_rate;
+    };
+    std::vector<Backend*> backends;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto& [backend, dev] : devices_) {
+            backends.push_back(backend);
+        }
+    }
+    // 读设备属性时不持有lock_，Monitor有自己的锁
+    std::vector<Reading> readings;
+    auto monitor = Monitor::getInstance();
+    for (auto backend : backends) {
+        auto prop = monitor->getProp(backend->getBackendType(), backend->getDeviceId());
+        if (prop.backend == nullptr) {
+            continue;
+        }
+        double memory_rate = prop.memory_total > 0 ? (double)prop.memory_used / prop.memory_total : 0.0;
+        readings.push_back({backend, prop.temperature_current, prop.temperature_limit, memory_rate});
+    }
+
+    std::vector<std::pair<size_t, Device*>> changed;  // 新事件的下标和设备
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        uint64_t now = Profiler::now();
+        for (auto& r : readings) {
+            auto& dev = device(r.backend);
+            // 没有上报温度上限的设备只看显存
+            int32_t headroom = r.limit > 0 ? r.limit - r.temperature : INT32_MAX;
+            auto level = classify(dev.level, headroom, r.memory_rate);
+            if (level == dev.level) {
+                continue;
+            }
+            if (dev.level != THROTTLE_NONE) {
+                dev.throttled_ns += now - dev.level_since;
+            }
+            changed.emplace_back(events_.size(), &dev);
+            events_.push_back({now, dev.name, dev.level, level, r.temperature, r.limit, r.memory_rate, 0});
+            dev.level = level;
+            dev.level_since = now;
+        }
+        if (!changed.empty()) {
+            updateLimits();
+        }
+        // 事件里记录切换后的上限
+        for (auto& [index, dev] : changed) {
+            auto& e = events_[index];
+            e.depth = dev->limit;
+            WARN_LOG("Governor: %s %s -> %s, temperature %d/%d, memory %.2f, depth limit %d", e.device.c_str(),
+                     levelName(e.from), levelName(e.to), e.temperature, e.temperature_limit, e.memory_rate,
+                     e.depth);
+        }
+    }
+    if (!changed.empty()) {
+        cond_.notify_all();
+    }
+}
+
+void Governor::updateLimits() {
+    // 还有没被暂停的设备时，过热的设备可以完全停下，任务都交给其他设备
+    bool others_available = false;
+    for (auto& [backend, dev] : devices_) {
+        others_available |= dev.capacity > 0 && dev.level != THROTTLE_HARD;
+    }
+    for (auto& [backend, dev] : devices_) {
+        switch (dev.level) {
+            case THROTTLE_NONE:
+                dev.limit = -1;
+                break;
+            case THROTTLE_SOFT:
+                dev.limit = std::max(cfg_.min_depth, dev.capacity / 2);
+                break;
+            case THROTTLE_HARD:
+                dev.limit = others_available ? 0 : cfg_.min_depth;
+                break;
+        }
+    }
+}
+
+void Governor::attach(Backend* backend, int depth) {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        device(backend).capacity += depth;
+        updateLimits();
+    }
+    cond_.notify_all();
+}
+
+void Governor::detach(Backend* backend, int depth) {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        device(backend).capacity -= depth;
+        updateLimits();
+    }
+    cond_.notify_all();
+}
+
+void Governor::acquire(Backend* backend) {
+    std::unique_lock<std::mutex> lock(lock_);
+    auto& dev = device(backend);
+    auto has_room = [this, &dev] { return stop_ || dev.limit < 0 || dev.inflight < dev.limit; };
+    if (!has_room()) {
+        dev.waits++;
+        cond_.wait(lock, has_room);
+    }
+    dev.inflight++;
+}
+
+void Governor::release(Backend* backend) {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        device(backend).inflight--;
+    }
+    cond_.notify_all();
+}
+
+ThrottleLevel Governor::level(Backend* backend) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = devices_.find(backend);
+    return it == devices_.end() ? THROTTLE_NONE : it->second.level;
+}
+
+std::vector<ThrottleEvent> Governor::events() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return events_;
+}
+
+void Governor::logStats() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto& [backend, dev] : devices_) {
+        size_t changes = std::count_if(events_.begin(), events_.end(),
+                                       [&dev](const ThrottleEvent& e) { return e.device == dev.name; });
+        INFO_LOG("Governor: %s level changes %zu, throttled %.1f ms, waits %lu", dev.name.c_str(), changes,
+                 dev.throttled_ns / 1e6, dev.waits);
+    }
+}
+
+std::string Governor::toJson() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::string out = "{\"devices\":[";
+    char buf[512];
+    bool first = true;
+    for (auto& [backend, dev] : devices_) {
+        snprintf(buf, sizeof(buf), "%s{\"device\":\"%s\",\"level\":\"%s\",\"throttled_ms\":%.1f,\"waits\":%lu}",
+                 first ? "" : ",", dev.name.c_str(), levelName(dev.level), dev.throttled_ns / 1e6, dev.waits);
+        out += buf;
+        first = false;
+    }
+    out += "],\"events\":[";
+    for (size_t i = 0; i < events_.size(); i++) {
+        auto& e = events_[i];
+        snprintf(buf, sizeof(buf),
+                 "%s{\"ts_ns\":%lu,\"device\":\"%s\",\"from\":\"%s\",\"to\":\"%s\",\"temperature\":%d,"
+                 "\"temperature_limit\":%d,\"memory_rate\":%.3f,\"depth\":%d}",
+                 i == 0 ? "" : ",", e.ts, e.device.c_str(), levelName(e.from), levelName(e.to), e.temperature,
+                 e.temperature_limit, e.memory_rate, e.depth);
+        out += buf;
+    }
+    out += "]}\n";
+    return out;
+}
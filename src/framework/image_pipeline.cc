@@ -0,0 +1,332 @@
+#include "image_pipeline.h"
+#include "convert.h"
+#include <cmath>
+#include <opencv2/imgcodecs.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IMAGE_PIPELINE_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define IMAGE_PIPELINE_NEON 1
+#endif
+
+namespace {
+
+// 与cv::resize的INTER_RESIZE_COEF_BITS一致
+constexpr int kCoefBits = 11;
+constexpr int kCoefScale = 1 << kCoefBits;
+
+// 两行横向插值结果做纵向混合，取整后饱和到uint8
+void vblendScalar(const int* h0, const int* h1, int b0, int b1, uint8_t* out, int n) {
+    for (int i = 0; i < n; i++) {
+        int v = (h0[i] * b0 + h1[i] * b1 + (1 << (2 * kCoefBits - 1))) >> (2 * kCoefBits);
+        out[i] = (uint8_t)std::min(std::max(v, 0), 255);
+    }
+}
+
+#if IMAGE_PIPELINE_X86
+__attribute__((target("avx2")))
+void vblendAvx2(const int* h0, const int* h1, int b0, int b1, uint8_t* out, int n) {
+    const __m256i vb0 = _mm256_set1_epi32(b0);
+    const __m256i vb1 = _mm256_set1_epi32(b1);
+    const __m256i round = _mm256_set1_epi32(1 << (2 * kCoefBits - 1));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(h0 + i)), vb0),
+                                     _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(h1 + i)), vb1));
+        __m256i b = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(h0 + i + 8)), vb0),
+                                     _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(h1 + i + 8)), vb1));
+        a = _mm256_srai_epi32(_mm256_add_epi32(a, round), 2 * kCoefBits);
+        b = _mm256_srai_epi32(_mm256_add_epi32(b, round), 2 * kCoefBits);
+        // pack按128位通道进行，需要重新排列
+        __m256i p16 = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+        __m256i p8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(p16, p16), 0xD8);
+        _mm_storeu_si128((__m128i*)(out + i), _mm256_castsi256_si128(p8));
+    }
+    vblendScalar(h0 + i, h1 + i, b0, b1, out + i, n - i);
+}
+#endif
+
+#if IMAGE_PIPELINE_NEON
+void vblendNeon(const int* h0, const int* h1, int b0, int b1, uint8_t* out, int n) {
+    const int32x4_t vb0 = vdupq_n_s32(b0);
+    const int32x4_t vb1 = vdupq_n_s32(b1);
+    const int32x4_t round = vdupq_n_s32(1 << (2 * kCoefBits - 1));
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t a = vmlaq_s32(vmlaq_s32(round, vld1q_s32(h0 + i), vb0), vld1q_s32(h1 + i), vb1);
+        int32x4_t b = vmlaq_s32(vmlaq_s32(round, vld1q_s32(h0 + i + 4), vb0), vld1q_s32(h1 + i + 4), vb1);
+        uint16x8_t p16 = vcombine_u16(vqmovun_s32(vshrq_n_s32(a, 2 * kCoefBits)),
+                                      vqmovun_s32(vshrq_n_s32(b, 2 * kCoefBits)));
+        vst1_u8(out + i, vqmovn_u16(p16));
+    }
+    vblendScalar(h0 + i, h1 + i, b0, b1, out + i, n - i);
+}
+#endif
+
+using VBlendFn = void (*)(const int*, const int*, int, int, uint8_t*, int);
+
+VBlendFn selectVBlend() {
+#if IMAGE_PIPELINE_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return vblendAvx2;
+    }
+#elif IMAGE_PIPELINE_NEON
+    return vblendNeon;
+#endif
+    return vblendScalar;
+}
+
+const VBlendFn vblend = selectVBlend();
+
+// 计算双线性插值的源坐标和定点权重，映射方式与cv::resize相同
+void linearCoeffs(int src_len, int dst_len, int offset, int count, std::vector<int>& idx0,
+                  std::vector<int>& idx1, std::vector<int>& w1) {
+    double scale = (double)src_len / dst_len;
+    idx0.resize(count);
+    idx1.resize(count);
+    w1.resize(count);
+    for (int i = 0; i < count; i++) {
+        double s = (i + offset + 0.5) * scale - 0.5;
+        int s0 = (int)std::floor(s);
+        double f = s - s0;
+        if (s0 < 0) {
+            s0 = 0;
+            f = 0;
+        }
+        if (s0 >= src_len - 1) {
+            s0 = src_len - 1;
+            f = 0;
+        }
+        idx0[i] = s0;
+        idx1[i] = std::min(s0 + 1, src_len - 1);
+        w1[i] = (int)std::lround(f * kCoefScale);
+    }
+}
+
+}  // namespace
+
+struct ImagePipeline::Geometry {
+    int src_h, src_w;
+    int out_h, out_w;
+    bool resize;
+    int crop_y, crop_x;                 // 缩放后图像中的裁剪起点
+    std::vector<int> y0, y1, wy;        // 每个输出行
+    std::vector<int> x0, x1, wx;        // 每个输出列
+};
+
+ImagePipeline::ImagePipeline(const ImagePipelineCfg& cfg) : cfg_(cfg) {
+    assert(cfg_.mean.size() == 3 && cfg_.std.size() == 3);
+    switch (cfg_.dtype) {
+        case FLOAT32: elem_size_ = 4; break;
+        case FLOAT16:
+        case BFLOAT16: elem_size_ = 2; break;
+        case INT8:
+        case UINT8: elem_size_ = 1; break;
+        default: assert(0);
+    }
+    // 输入像素只有256种取值，归一化和类型转换全部预先算好
+    lut_.resize(3 * 256 * elem_size_);
+    for (int c = 0; c < 3; c++) {
+        for (int v = 0; v < 256; v++) {
+            float f = (v * cfg_.scale - cfg_.mean[c]) / cfg_.std[c];
+            uint8_t* slot = lut_.data() + (c * 256 + v) * elem_size_;
+            if (cfg_.dtype == FLOAT32) {
+                std::memcpy(slot, &f, 4);
+            } else if (cfg_.dtype == FLOAT16) {
+                uint16_t h = floatToHalf(f);
+                std::memcpy(slot, &h, 2);
+            } else if (cfg_.dtype == BFLOAT16) {
+                uint16_t h = floatToBf16(f);
+                std::memcpy(slot, &h, 2);
+            } else if (cfg_.dtype == INT8) {
+                *slot = (uint8_t)(int8_t)std::min(127.0f, std::max(-128.0f, std::round(f / cfg_.quant_scale)));
+            } else {
+                *slot = (uint8_t)std::min(255.0f, std::max(0.0f, std::round(f / cfg_.quant_scale)));
+            }
+        }
+    }
+}
+
+void ImagePipeline::resizedSize(int src_h, int src_w, int& h, int& w) const {
+    h = src_h;
+    w = src_w;
+    if (cfg_.resize_short <= 0) {
+        return;
+    }
+    // 与原resnetPreprocess相同，长边按比例截断取整
+    if (src_h < src_w) {
+        h = cfg_.resize_short;
+        w = static_cast<int>(src_w * (double)cfg_.resize_short / src_h);
+    } else {
+        w = cfg_.resize_short;
+        h = static_cast<int>(src_h * (double)cfg_.resize_short / src_w);
+    }
+}
+
+std::vector<uint32_t> ImagePipeline::outputShape(int src_h, int src_w) const {
+    int h, w;
+    resizedSize(src_h, src_w, h, w);
+    if (cfg_.crop_h > 0 && cfg_.crop_w > 0) {
+        h = cfg_.crop_h;
+        w = cfg_.crop_w;
+    }
+    if (cfg_.chw) {
+        return {3, (uint32_t)h, (uint32_t)w};
+    }
+    return {(uint32_t)h, (uint32_t)w, 3};
+}
+
+size_t ImagePipeline::outputSize(int src_h, int src_w) const {
+    auto shape = outputShape(src_h, src_w);
+    return (size_t)shape[0] * shape[1] * shape[2] * elem_size_;
+}
+
+// 同一路数据的图片尺寸通常固定，按尺寸缓存插值表
+std::shared_ptr<const ImagePipeline::Geometry> ImagePipeline::geometry(int src_h, int src_w) const {
+    std::lock_guard<std::mutex> lock(geo_lock_);
+    for (auto& g : geo_cache_) {
+        if (g->src_h == src_h && g->src_w == src_w) {
+            return g;
+        }
+    }
+    auto geo = std::make_shared<Geometry>();
+    geo->src_h = src_h;
+    geo->src_w = src_w;
+    int rh, rw;
+    resizedSize(src_h, src_w, rh, rw);
+    geo->resize = rh != src_h || rw != src_w;
+    geo->out_h = rh;
+    geo->out_w = rw;
+    geo->crop_y = geo->crop_x = 0;
+    if (cfg_.crop_h > 0 && cfg_.crop_w > 0) {
+        geo->out_h = cfg_.crop_h;
+        geo->out_w = cfg_.crop_w;
+        geo->crop_y = (rh - cfg_.crop_h) / 2;
+        geo->crop_x = (rw - cfg_.crop_w) / 2;
+    }
+    if (geo->resize) {
+        linearCoeffs(src_h, rh, geo->crop_y, geo->out_h, geo->y0, geo->y1, geo->wy);
+        linearCoeffs(src_w, rw, geo->crop_x, geo->out_w, geo->x0, geo->x1, geo->wx);
+    }
+    if (geo_cache_.size() >= 8) {
+        geo_cache_.erase(geo_cache_.begin());
+    }
+    geo_cache_.push_back(geo);
+    return geo;
+}
+
+template <typename T>
+void ImagePipeline::runTyped(const uint8_t* src, size_t src_stride, const Geometry& geo, T* dst) const {
+    const int out_w = geo.out_w;
+    const int n = out_w * 3;
+    const T* lut = reinterpret_cast<const T*>(lut_.data());
+    // 输出通道c取自输入的第src_c[c]个通道
+    const int src_c[3] = {cfg_.to_rgb ? 2 : 0, 1, cfg_.to_rgb ? 0 : 2};
+    const size_t plane = (size_t)geo.out_h * out_w;
+
+    // 每个线程一份行缓冲，缓存最近两行的横向插值结果
+    thread_local std::vector<int> hrows[2];
+    thread_local std::vector<uint8_t> row;
+    int cached[2] = {-1, -1};
+    if (geo.resize) {
+        hrows[0].resize(n);
+        hrows[1].resize(n);
+    }
+    row.resize(n);
+
+    // keep为正在使用、不能被替换的行
+    auto hresize = [&](int sy, const int* keep) -> const int* {
+        for (int k = 0; k < 2; k++) {
+            if (cached[k] == sy) {
+                return hrows[k].data();
+            }
+        }
+        int k = hrows[0].data() == keep ? 1 : 0;
+        cached[k] = sy;
+        const uint8_t* s = src + sy * src_stride;
+        int* h = hrows[k].data();
+        for (int x = 0; x < out_w; x++) {
+            const uint8_t* p0 = s + geo.x0[x] * 3;
+            const uint8_t* p1 = s + geo.x1[x] * 3;
+            int a1 = geo.wx[x];
+            int a0 = kCoefScale - a1;
+            h[x * 3] = p0[0] * a0 + p1[0] * a1;
+            h[x * 3 + 1] = p0[1] * a0 + p1[1] * a1;
+            h[x * 3 + 2] = p0[2] * a0 + p1[2] * a1;
+        }
+        return h;
+    };
+
+    for (int y = 0; y < geo.out_h; y++) {
+        const uint8_t* pix;
+        if (geo.resize) {
+            const int* h0 = hresize(geo.y0[y], nullptr);
+            const int* h1 = hresize(geo.y1[y], h0);
+            int b1 = geo.wy[y];
+            vblend(h0, h1, kCoefScale - b1, b1, row.data(), n);
+            pix = row.data();
+        } else {
+            pix = src + (y + geo.crop_y) * src_stride + geo.crop_x * 3;
+        }
+        // 查表完成归一化和类型转换，同时完成通道交换和HWC->CHW
+        if (cfg_.chw) {
+            for (int c = 0; c < 3; c++) {
+                const T* l = lut + c * 256;
+                const uint8_t* p = pix + src_c[c];
+                T* out = dst + c * plane + (size_t)y * out_w;
+                for (int x = 0; x < out_w; x++) {
+                    out[x] = l[p[x * 3]];
+                }
+            }
+        } else {
+            T* out = dst + (size_t)y * n;
+            for (int x = 0; x < out_w; x++) {
+                out[x * 3] = lut[pix[x * 3 + src_c[0]]];
+                out[x * 3 + 1] = lut[256 + pix[x * 3 + src_c[1]]];
+                out[x * 3 + 2] = lut[512 + pix[x * 3 + src_c[2]]];
+            }
+        }
+    }
+}
+
+Result ImagePipeline::run(const uint8_t* src, int src_h, int src_w, size_t src_stride, void* dst) const {
+    if (src == nullptr || src_h <= 0 || src_w <= 0) {
+        ERROR_LOG("ImagePipeline: invalid input image");
+        return FAIL;
+    }
+    auto geo = geometry(src_h, src_w);
+    int rh, rw;
+    resizedSize(src_h, src_w, rh, rw);
+    if (geo->out_h > rh || geo->out_w > rw) {
+        ERROR_LOG("ImagePipeline: crop %dx%d is larger than image %dx%d", geo->out_w, geo->out_h, rw, rh);
+        return FAIL;
+    }
+    switch (elem_size_) {
+        case 4: runTyped(src, src_stride, *geo, static_cast<float*>(dst)); break;
+        case 2: runTyped(src, src_stride, *geo, static_cast<uint16_t*>(dst)); break;
+        default: runTyped(src, src_stride, *geo, static_cast<uint8_t*>(dst)); break;
+    }
+    return SUCCESS;
+}
+
+PreprocessFn ImagePipeline::makePreprocessFn() const {
+    return [this](const std::any& arg) -> std::vector<uint8_t> {
+        auto path = std::any_cast<std::string>(&arg);
+        if (path == nullptr) {
+            ERROR_LOG("ImagePipeline: preprocess argument must be an image path");
+            return {};
+        }
+        cv::Mat img = cv::imread(*path, cv::IMREAD_COLOR);
+        if (img.empty()) {
+            ERROR_LOG("ImagePipeline: can not read %s", path->c_str());
+            return {};
+        }
+        std::vector<uint8_t> bytes(outputSize(img.rows, img.cols));
+        if (run(img.data, img.rows, img.cols, img.step, bytes.data()) != SUCCESS) {
+            return {};
+        }
+        return bytes;
+    };
+}
@@ -0,0 +1,183 @@
+#include "logger.h"
+#include "mpmc_queue.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+
+namespace {
+
+constexpr size_t kRingCapacity = 4096;
+constexpr size_t kMaxLine = 512;
+
+struct LogRecord {
+    int level{0};
+    uint32_t len{0};
+    char text[kMaxLine];
+};
+
+uint64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void writeLine(int level, const char* text, size_t len) {
+    FILE* out = level >= LOG_LEVEL_ERROR ? stderr : stdout;
+    fwrite(text, 1, len, out);
+}
+
+}  // namespace
+
+struct Logger::Impl {
+    Impl() : ring(kRingCapacity) {}
+
+    MPMCQueue<LogRecord> ring;
+    std::atomic<bool> async{true};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> sleeping{false};
+    std::mutex lock;
+    std::condition_variable cond;
+    std::thread worker;
+
+    // 返回是否写出了日志
+    bool drain() {
+        LogRecord record;
+        bool wrote = false;
+        while (ring.tryPop(record)) {
+            writeLine(record.level, record.text, record.len);
+            wrote = true;
+        }
+        if (wrote) {
+            fflush(stdout);
+        }
+        return wrote;
+    }
+
+    void loop() {
+        while (!stop.load(std::memory_order_acquire)) {
+            if (drain()) {
+                continue;
+            }
+            // 生产者看到sleeping才notify，漏掉的唤醒最多延迟10ms
+            std::unique_lock<std::mutex> guard(lock);
+            sleeping.store(true, std::memory_order_seq_cst);
+            if (ring.size() == 0) {
+                cond.wait_for(guard, std::chrono::milliseconds(10));
+            }
+            sleeping.store(false, std::memory_order_relaxed);
+        }
+        drain();
+    }
+};
+
+Logger* Logger::getInstance() {
+    // 故意不析构，其他静态对象析构时仍然可以打日志
+    static Logger* logger = [] {
+        auto l = new Logger();
+        std::atexit([] { Logger::getInstance()->shutdown(); });
+        return l;
+    }();
+    return logger;
+}
+
+Logger::Logger() : impl_(new Impl()) {
+    impl_->worker = std::thread(&Impl::loop, impl_);
+}
+
+void Logger::setAsync(bool async) {
+    if (!async) {
+        flush();
+    }
+    impl_->async.store(async, std::memory_order_release);
+}
+
+void Logger::flush() {
+    // 后台线程也在pop，这里一起帮忙写，写完后队列为空
+    impl_->drain();
+    fflush(stdout);
+    fflush(stderr);
+}
+
+void Logger::shutdown() {
+    impl_->async.store(false, std::memory_order_release);
+    impl_->stop.store(true, std::memory_order_release);
+    impl_->cond.notify_one();
+    if (impl_->worker.joinable()) {
+        impl_->worker.join();
+    }
+    flush();
+}
+
+int Logger::levelFromString(const std::string& str) {
+    if (str == "debug") return LOG_LEVEL_DEBUG;
+    else if (str == "info") return LOG_LEVEL_INFO;
+    else if (str == "warn") return LOG_LEVEL_WARN;
+    else if (str == "error") return LOG_LEVEL_ERROR;
+    else if (str == "off") return LOG_LEVEL_OFF;
+    return LOG_LEVEL;
+}
+
+// 同一调用点每秒最多rate_limit_条，下个窗口第一条日志前补一条被丢弃的数量
+bool Logger::allow(LogSite* site) {
+    auto limit = rate_limit_.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return true;
+    }
+    auto now = nowSeconds();
+    auto window = site->window.load(std::memory_order_relaxed);
+    if (window != now && site->window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+        site->count.store(0, std::memory_order_relaxed);
+        auto suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0) {
+            char text[96];
+            int len = snprintf(text, sizeof(text), "[WARN]  %u similar log messages suppressed\n", suppressed);
+            emit(LOG_LEVEL_WARN, text, len);
+        }
+    }
+    if (site->count.fetch_add(1, std::memory_order_relaxed) < limit) {
+        return true;
+    }
+    site->suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void Logger::log(int level, LogSite* site, const char* fmt, ...) {
+    if (!allow(site)) {
+        return;
+    }
+    char text[kMaxLine];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    if (len < 0) {
+        return;
+    }
+    if ((size_t)len >= sizeof(text)) {
+        // 截断时保留换行
+        len = sizeof(text) - 1;
+        text[len - 1] = '\n';
+    }
+    emit(level, text, len);
+}
+
+void Logger::emit(int level, const char* text, size_t len) {
+    if (!impl_->async.load(std::memory_order_acquire)) {
+        writeLine(level, text, len);
+        return;
+    }
+    LogRecord record;
+    record.level = level;
+    record.len = len;
+    std::memcpy(record.text, text, len);
+    if (!impl_->ring.tryPush(record)) {
+        if (level >= LOG_LEVEL_ERROR) {
+            writeLine(level, text, len);
+        } else {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    if (impl_->sleeping.load(std::memory_order_seq_cst)) {
+        impl_->cond.notify_one();
+    }
+}
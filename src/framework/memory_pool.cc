@@ -0,0 +1,130 @@
+#include "memory_pool.h"
+#include "backend/backend.h"
+#include "model_info.h"
+
+size_t MemoryPool::bucketSize(size_t size) {
+    return (size_t)1 << (bucketIndex(size) + kMinShift);
+}
+
+int MemoryPool::bucketIndex(size_t size) {
+    int idx = 0;
+    size_t cap = (size_t)1 << kMinShift;
+    while (cap < size) {
+        cap <<= 1;
+        idx++;
+    }
+    assert(idx < kNumBuckets);
+    return idx;
+}
+
+void* MemoryPool::acquire(size_t size) {
+    int idx = bucketIndex(size);
+    size_t bsize = (size_t)1 << (idx + kMinShift);
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto& list = free_lists_[idx];
+        if (!list.empty()) {
+            void* ptr = list.back();
+            list.pop_back();
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            bytes_held_.fetch_sub(bsize, std::memory_order_relaxed);
+            bytes_in_use_.fetch_add(bsize, std::memory_order_relaxed);
+            return ptr;
+        }
+    }
+
+    // 桶里没有空闲块，向后端申请一整个桶大小
+    void* ptr = nullptr;
+    auto res = host_ ? backend_->mallocHost(&ptr, bsize) : backend_->malloc(&ptr, bsize);
+    if (res != SUCCESS || ptr == nullptr) {
+        ERROR_LOG("MemoryPool: backend malloc %zu bytes failed", bsize);
+        return nullptr;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    bytes_in_use_.fetch_add(bsize, std::memory_order_relaxed);
+    return ptr;
+}
+
+void MemoryPool::release(void* dev_ptr, size_t size) {
+    if (dev_ptr == nullptr) {
+        return;
+    }
+    int idx = bucketIndex(size);
+    size_t bsize = (size_t)1 << (idx + kMinShift);
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        free_lists_[idx].push_back(dev_ptr);
+    }
+    bytes_in_use_.fetch_sub(bsize, std::memory_order_relaxed);
+    bytes_held_.fetch_add(bsize, std::memory_order_relaxed);
+}
+
+void MemoryPool::trim() {
+    std::vector<void*> to_free;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (int i = 0; i < kNumBuckets; i++) {
+            size_t bsize = (size_t)1 << (i + kMinShift);
+            for (auto ptr : free_lists_[i]) {
+                to_free.push_back(ptr);
+                bytes_held_.fetch_sub(bsize, std::memory_order_relaxed);
+            }
+            free_lists_[i].clear();
+        }
+    }
+    for (auto ptr : to_free) {
+        if (host_) {
+            backend_->freeHost(ptr);
+        } else {
+            backend_->free(ptr);
+        }
+    }
+}
+
+MemoryPool::Stats MemoryPool::getStats() const {
+    Stats s;
+    s.hits = hits_.load(std::memory_order_relaxed);
+    s.misses = misses_.load(std::memory_order_relaxed);
+    s.bytes_held = bytes_held_.load(std::memory_order_relaxed);
+    s.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void* PoolCache::acquire(size_t size) {
+    size_t bsize = MemoryPool::bucketSize(size);
+    for (size_t i = 0; i < blocks_.size(); i++) {
+        if (blocks_[i].bucket_size == bsize) {
+            void* ptr = blocks_[i].ptr;
+            blocks_[i] = blocks_.back();
+            blocks_.pop_back();
+            pool_->hits_.fetch_add(1, std::memory_order_relaxed);
+            pool_->bytes_held_.fetch_sub(bsize, std::memory_order_relaxed);
+            pool_->bytes_in_use_.fetch_add(bsize, std::memory_order_relaxed);
+            return ptr;
+        }
+    }
+    return pool_->acquire(size);
+}
+
+void PoolCache::release(void* dev_ptr, size_t size) {
+    if (dev_ptr == nullptr) {
+        return;
+    }
+    if (blocks_.size() >= capacity_) {
+        pool_->release(dev_ptr, size);
+        return;
+    }
+    size_t bsize = MemoryPool::bucketSize(size);
+    blocks_.push_back({dev_ptr, bsize});
+    pool_->bytes_in_use_.fetch_sub(bsize, std::memory_order_relaxed);
+    pool_->bytes_held_.fetch_add(bsize, std::memory_order_relaxed);
+}
+
+void PoolCache::flush() {
+    for (auto& b : blocks_) {
+        // bytes_held在本地缓存时已计入，这里直接放回对应的桶
+        std::lock_guard<std::mutex> lock(pool_->lock_);
+        pool_->free_lists_[MemoryPool::bucketIndex(b.bucket_size)].push_back(b.ptr);
+    }
+    blocks_.clear();
+}
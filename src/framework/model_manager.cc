@@ -0,0 +1,179 @@
+#include "model_manager.h"
+#include "monitor.h"
+
+EvictPolicy stringToEvictPolicy(const std::string& str) {
+    if (str == "lru") return EVICT_LRU;
+    else if (str == "lfu") return EVICT_LFU;
+    else {
+        WARN_LOG("unknown evict policy %s, use lru", str.c_str());
+        return EVICT_LRU;
+    }
+}
+
+ModelManager::ModelManager(Backend* backend, const ModelManagerCfg& cfg) : backend_(backend), cfg_(cfg) {
+    for (auto& path : cfg_.preload) {
+        if (pin(path) != SUCCESS) {
+            WARN_LOG("ModelManager: preload %s failed", path.c_str());
+        }
+    }
+}
+
+ModelManager::~ModelManager() {
+    for (auto& s : stats()) {
+        INFO_LOG("ModelManager[%d] %s: hits %lu, loads %lu, evictions %lu, avg load %.1f ms, %lu bytes",
+                 backend_->getDeviceId(), s.path.c_str(), s.hits, s.loads, s.evictions,
+                 s.loads ? s.load_us / 1000.0 / s.loads : 0.0, s.device_bytes);
+    }
+}
+
+ModelHandle ModelManager::get(const std::string& path) {
+    uint64_t used_before = 0, total = 0;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto& entry = entries_[path];
+        entry.stats.path = path;
+        entry.last_use = ++clock_;
+        entry.uses++;
+        if (entry.handle) {
+            entry.stats.hits++;
+            return entry.handle;
+        }
+        // 重新加载时按上次测得的大小预留，第一次加载时大小未知
+        makeRoom(entry.stats.device_bytes, path);
+        memoryUsage(used_before, total);
+    }
+
+    // 加载不持有lock_，同一模型的并发加载由ModelRegistry合并成一次
+    auto begin = std::chrono::steady_clock::now();
+    auto handle = backend_->acquireModel(path);
+    auto load_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    if (!handle) {
+        ERROR_LOG("ModelManager: load %s failed", path.c_str());
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    auto& entry = entries_[path];
+    if (!entry.handle) {
+        uint64_t bytes = handle->getDeviceBytes();
+        if (bytes == 0) {
+            // 后端不知道模型大小时用加载前后的设备内存差估算
+            uint64_t used_after = 0;
+            memoryUsage(used_after, total);
+            bytes = used_after > used_before ? used_after - used_before : 0;
+        }
+        entry.handle = handle;
+        entry.stats.loads++;
+        entry.stats.load_us += load_us;
+        entry.stats.device_bytes = bytes;
+        entry.stats.resident = true;
+        DEBUG_LOG("ModelManager: loaded %s, %lu bytes in %ld us", path.c_str(), bytes, (long)load_us);
+    }
+    // 大小未知的模型加载后可能已经越过水位线
+    makeRoom(0, path);
+    return handle;
+}
+
+Result ModelManager::pin(const std::string& path) {
+    auto handle = get(path);
+    if (!handle) {
+        return FAIL;
+    }
+    std::lock_guard<std::mutex> lock(lock_);
+    entries_[path].stats.pinned = true;
+    return SUCCESS;
+}
+
+void ModelManager::unpin(const std::string& path) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+        it->second.stats.pinned = false;
+    }
+}
+
+std::vector<ModelStats> ModelManager::stats() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::vector<ModelStats> result;
+    result.reserve(entries_.size());
+    for (auto& [path, entry] : entries_) {
+        result.push_back(entry.stats);
+    }
+    return result;
+}
+
+size_t ModelManager::residentCount() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return std::count_if(entries_.begin(), entries_.end(), [](auto& kv) { return kv.second.handle != nullptr; });
+}
+
+void ModelManager::memoryUsage(uint64_t& used, uint64_t& total) const {
+    auto prop = Monitor::getInstance()->getProp(backend_->getBackendType(), backend_->getDeviceId());
+    if (prop.backend != nullptr && prop.memory_total > 0) {
+        used = prop.memory_used;
+        total = prop.memory_total;
+        return;
+    }
+    used = 0;
+    total = 0;
+    for (auto& [path, entry] : entries_) {
+        if (entry.handle) {
+            used += entry.stats.device_bytes;
+        }
+    }
+}
+
+void ModelManager::makeRoom(uint64_t extra, const std::string& keep) {
+    for (;;) {
+        size_t resident = 0;
+        for (auto& [path, entry] : entries_) {
+            resident += entry.handle != nullptr;
+        }
+        size_t incoming = entries_[keep].handle ? 0 : 1;
+        bool over_count = cfg_.max_resident > 0 && resident + incoming > cfg_.max_resident;
+        uint64_t used = 0, total = 0;
+        memoryUsage(used, total);
+        bool over_mem = total > 0 && used + extra > cfg_.watermark * total;
+        if (!over_count && !over_mem) {
+            return;
+        }
+        Entry* victim = pickVictim(keep);
+        if (victim == nullptr) {
+            WARN_LOG("ModelManager[%d]: %lu/%lu bytes used, %zu models resident, nothing to evict",
+                     backend_->getDeviceId(), used, total, resident);
+            return;
+        }
+        evict(*victim);
+    }
+}
+
+ModelManager::Entry* ModelManager::pickVictim(const std::string& keep) {
+    Entry* victim = nullptr;
+    for (auto& [path, entry] : entries_) {
+        // 除了管理器自己还有人持有句柄的模型正在使用，放掉也不会释放内存
+        if (path == keep || !entry.handle || entry.stats.pinned || entry.handle.use_count() > 1) {
+            continue;
+        }
+        if (victim == nullptr) {
+            victim = &entry;
+            continue;
+        }
+        bool colder = cfg_.policy == EVICT_LFU
+            ? (entry.uses < victim->uses || (entry.uses == victim->uses && entry.last_use < victim->last_use))
+            : entry.last_use < victim->last_use;
+        if (colder) {
+            victim = &entry;
+        }
+    }
+    return victim;
+}
+
+void ModelManager::evict(Entry& entry) {
+    INFO_LOG("ModelManager[%d]: evict %s (%lu bytes)", backend_->getDeviceId(), entry.stats.path.c_str(),
+             entry.stats.device_bytes);
+    // 管理器持有的是最后一个引用，这里同步卸载
+    entry.handle.reset();
+    entry.stats.evictions++;
+    entry.stats.resident = false;
+}
@@ -0,0 +1,75 @@
+#include "model_registry.h"
+#include "backend/backend.h"
+
+ModelRegistry::~ModelRegistry() {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!by_path_.empty()) {
+        WARN_LOG("ModelRegistry: %zu model(s) still referenced at destruction", by_path_.size());
+    }
+}
+
+ModelHandle ModelRegistry::acquire(const std::string& path) {
+    std::unique_lock<std::mutex> lock(lock_);
+    for (;;) {
+        auto it = by_path_.find(path);
+        if (it != by_path_.end()) {
+            if (auto handle = it->second.lock()) {
+                return handle;
+            }
+            // 引用已归零，释放函数马上会把它移除
+        } else if (busy_.count(path) == 0) {
+            break;
+        }
+        cond_.wait(lock);
+    }
+    busy_.insert(path);
+    lock.unlock();
+
+    auto model = loader_(path);
+
+    lock.lock();
+    busy_.erase(path);
+    cond_.notify_all();
+    if (model == nullptr) {
+        return nullptr;
+    }
+    model->id_ = next_id_++;
+    model->path_ = path;
+    ModelHandle handle(model.release(), [this](Model* m) { release(m); });
+    by_path_[path] = handle;
+    publish(handle->getId(), handle.get());
+    DEBUG_LOG("ModelRegistry: loaded %s as model %u", path.c_str(), handle->getId());
+    return handle;
+}
+
+const Model* ModelRegistry::find(uint32_t id) const {
+    auto snapshot = std::atomic_load(&snapshot_);
+    auto it = snapshot->find(id);
+    return it == snapshot->end() ? nullptr : it->second;
+}
+
+void ModelRegistry::publish(uint32_t id, const Model* model) {
+    auto next = std::make_shared<Snapshot>(*snapshot_);
+    if (model != nullptr) {
+        (*next)[id] = model;
+    } else {
+        next->erase(id);
+    }
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(next)));
+}
+
+void ModelRegistry::release(Model* model) {
+    std::string path = model->getPath();
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        by_path_.erase(path);
+        publish(model->getId(), nullptr);
+        // 卸载完成前不允许重新加载同一路径，避免两份同时占用设备内存
+        busy_.insert(path);
+    }
+    unloader_(model);
+    delete model;
+    std::lock_guard<std::mutex> lock(lock_);
+    busy_.erase(path);
+    cond_.notify_all();
+}
@@ -1,41 +1,85 @@
 #include "monitor.h"
 
-Result Monitor::init() {
-    // 开启监控线程
-    // monitor_thread_ = std::thread([this]() {
-    //     while (!stop_) {
-    //         for (auto& [type, prop] : props_) {
-    //             prop.update();
-    //         }
-    //         std::this_thread::sleep_for(std::chrono::seconds(1));
-    //     }
-    // });
+std::string deviceLabel(BackendType type, int id) {
+    const char* name = type == BACKEND_LYNXI ? "lynxi" : type == BACKEND_DUMMY ? "dummy" : "cpu";
+    return std::string(name) + ":" + std::to_string(id);
+}
 
+Result Monitor::init() {
+    // 设备属性由Telemetry的采样线程定期刷新，没有启动Telemetry时getProp按需刷新
+    auto telemetry = Telemetry::getInstance();
+    telemetry->describe("infer_device_memory_used_bytes", METRIC_GAUGE, "Device memory in use");
+    telemetry->describe("infer_device_memory_total_bytes", METRIC_GAUGE, "Device memory capacity");
+    telemetry->describe("infer_device_usage_percent", METRIC_GAUGE, "Compute unit usage since last sample");
+    telemetry->describe("infer_device_temperature_celsius", METRIC_GAUGE, "Current chip temperature");
+    telemetry->describe("infer_device_temperature_limit_celsius", METRIC_GAUGE, "Shutdown temperature");
+    telemetry->describe("infer_pool_hits_total", METRIC_COUNTER, "Device memory pool cache hits");
+    telemetry->describe("infer_pool_misses_total", METRIC_COUNTER, "Device memory pool misses (backend malloc)");
+    telemetry->describe("infer_pool_held_bytes", METRIC_GAUGE, "Free bytes cached in the device memory pool");
+    telemetry->describe("infer_pool_in_use_bytes", METRIC_GAUGE, "Bytes lent out by the device memory pool");
+    collector_id_ = telemetry->addCollector([this](const Telemetry::Emit& emit) {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto& [key, prop] : props_) {
+            prop.update();
+            MetricLabels labels{{"device", deviceLabel(key.first, key.second)}};
+            emit("infer_device_memory_used_bytes", labels, prop.memory_used);
+            emit("infer_device_memory_total_bytes", labels, prop.memory_total);
+            emit("infer_device_usage_percent", labels, prop.usage_rate);
+            emit("infer_device_temperature_celsius", labels, prop.temperature_current);
+            emit("infer_device_temperature_limit_celsius", labels, prop.temperature_limit);
+            auto stats = prop.backend->getMemoryPool()->getStats();
+            emit("infer_pool_hits_total", labels, stats.hits);
+            emit("infer_pool_misses_total", labels, stats.misses);
+            emit("infer_pool_held_bytes", labels, stats.bytes_held);
+            emit("infer_pool_in_use_bytes", labels, stats.bytes_in_use);
+        }
+    });
     return SUCCESS;
 }
 
-Backend* Monitor::getBackend(BackendType type) {
-    auto it = backends_.find(type);
+Backend* Monitor::getBackend(BackendType type, int device_id) {
+    std::lock_guard<std::mutex> lock(lock_);
+    DeviceKey key{type, device_id};
+    auto it = backends_.find(key);
     if (it == backends_.end()) {
-        auto backend = BackendFactory::createBackend(type);
+        auto backend = BackendFactory::createBackend(type, device_id);
         if (!backend) {
-            ERROR_LOG("can not create backend");
+            ERROR_LOG("can not create backend, device id = %d", device_id);
             return nullptr;
         }
-        backends_[type] = std::move(backend);
-        props_.emplace(type, Prop{type, 0}); // warn: assume only one device and id is zero
-        return backends_[type].get();
+        auto ptr = backend.get();
+        backends_[key] = std::move(backend);
+        props_.emplace(key, Prop{type, device_id, ptr});
+        return ptr;
     }
     return it->second.get();
 }
 
-float Monitor::getMemUsedRate(BackendType type) {
-    auto it = props_.find(type);
+Prop Monitor::getProp(BackendType type, int device_id) {
+    // update会推进Dummy的使用率窗口和温度积分，多方各自刷新会互相吞掉对方的窗口，只留采样线程一个刷新方
+    // running在拿lock_之前问，避免和持有lock_的collector交叉加锁
+    bool refresh = !Telemetry::getInstance()->running();
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = props_.find({type, device_id});
     if (it == props_.end()) {
+        return Prop{type, device_id};
+    }
+    if (refresh) {
+        it->second.update();
+    }
+    return it->second;
+}
+
+float Monitor::getMemUsedRate(BackendType type, int device_id) {
+    auto prop = getProp(type, device_id);
+    if (prop.backend == nullptr) {
         ERROR_LOG("prop doesn't exist");
         return 0.0;
     }
-    return (float)(it->second.memory_used) / (float)(it->second.memory_total);
+    if (prop.memory_total == 0) {
+        return 0.0;
+    }
+    return (float)(prop.memory_used) / (float)(prop.memory_total);
 }
 
 void Prop::update() {
@@ -51,5 +95,12 @@ void Prop::update() {
         usage_rate = device_prop.deviceApuUsageRate;
         temperature_current = device_prop.deviceTemperatureCurrent;
         temperature_limit = device_prop.deviceTemperatureLimit;
+    } else if (type == BACKEND_DUMMY && backend != nullptr) {
+        auto dummy = static_cast<Dummy*>(backend);
+        memory_used = dummy->memoryUsed();
+        memory_total = dummy->memoryTotal();
+        usage_rate = dummy->usageRate();
+        temperature_current = dummy->temperature();
+        temperature_limit = dummy->temperatureLimit();
     }
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "placement.h"
+#include "monitor.h"
+
+PlacementPolicy stringToPlacementPolicy(const std::string& str) {
+    if (str == "round_robin") return PLACE_ROUND_ROBIN;
+    else if (str == "weighted") return PLACE_WEIGHTED;
+    else if (str == "least_loaded") return PLACE_LEAST_LOADED;
+    WARN_LOG("unknown device_policy %s, use round_robin", str.c_str());
+    return PLACE_ROUND_ROBIN;
+}
+
+std::vector<Backend*> Placement::assign(const std::vector<Backend*>& backends,
+                                        const std::vector<float>& weights,
+                                        int num_executor, PlacementPolicy policy) {
+    assert(!backends.empty());
+    assert(weights.size() == backends.size());
+    std::vector<Backend*> result;
+    switch (policy) {
+        case PLACE_WEIGHTED:
+            result = weighted(backends, weights, num_executor);
+            break;
+        case PLACE_LEAST_LOADED:
+            result = leastLoaded(backends, weights, num_executor);
+            break;
+        default:
+            result = roundRobin(backends, num_executor);
+            break;
+    }
+    for (size_t d = 0; d < backends.size(); d++) {
+        auto n = std::count(result.begin(), result.end(), backends[d]);
+        INFO_LOG("Placement: device %d (type %d) gets %ld executors",
+                 backends[d]->getDeviceId(), backends[d]->getBackendType(), n);
+    }
+    return result;
+}
+
+std::vector<Backend*> Placement::roundRobin(const std::vector<Backend*>& backends, int num_executor) {
+    std::vector<Backend*> result;
+    result.reserve(num_executor);
+    for (int i = 0; i < num_executor; i++) {
+        result.push_back(backends[i % backends.size()]);
+    }
+    return result;
+}
+
+// 平滑加权轮询，相邻的executor尽量落在不同设备上
+std::vector<Backend*> Placement::weighted(const std::vector<Backend*>& backends,
+                                          const std::vector<float>& weights, int num_executor) {
+    float total = 0.0f;
+    for (auto w : weights) {
+        total += std::max(w, 0.0f);
+    }
+    if (total <= 0.0f) {
+        return roundRobin(backends, num_executor);
+    }
+    std::vector<float> current(backends.size(), 0.0f);
+    std::vector<Backend*> result;
+    result.reserve(num_executor);
+    for (int i = 0; i < num_executor; i++) {
+        size_t best = 0;
+        for (size_t d = 0; d < backends.size(); d++) {
+            current[d] += std::max(weights[d], 0.0f);
+            if (current[d] > current[best]) {
+                best = d;
+            }
+        }
+        current[best] -= total;
+        result.push_back(backends[best]);
+    }
+    return result;
+}
+
+// 每放一个executor都选择放上去之后负载最小的设备
+// 负载 = 已分配executor数 / weight * (1 + 使用率 + 显存占用率)，显存快满的设备不再分配
+std::vector<Backend*> Placement::leastLoaded(const std::vector<Backend*>& backends,
+                                             const std::vector<float>& weights, int num_executor) {
+    constexpr float kMemHighWater = 0.95f;
+    auto monitor = Monitor::getInstance();
+    std::vector<float> pressure(backends.size(), 1.0f);
+    std::vector<bool> full(backends.size(), false);
+    for (size_t d = 0; d < backends.size(); d++) {
+        auto prop = monitor->getProp(backends[d]->getBackendType(), backends[d]->getDeviceId());
+        if (prop.backend == nullptr) {
+            continue;
+        }
+        float mem = prop.memory_total == 0 ? 0.0f : (float)prop.memory_used / (float)prop.memory_total;
+        pressure[d] = 1.0f + (float)prop.usage_rate / 100.0f + mem;
+        full[d] = mem >= kMemHighWater;
+    }
+    bool all_full = std::all_of(full.begin(), full.end(), [](bool f) { return f; });
+
+    std::vector<int> assigned(backends.size(), 0);
+    std::vector<Backend*> result;
+    result.reserve(num_executor);
+    for (int i = 0; i < num_executor; i++) {
+        int best = -1;
+        float best_load = 0.0f;
+        for (size_t d = 0; d < backends.size(); d++) {
+            if (full[d] && !all_full) {
+                continue;
+            }
+            float w = weights[d] > 0.0f ? weights[d] : 1.0f;
+            float load = (assigned[d] + 1) / w * pressure[d];
+            if (best < 0 || load < best_load) {
+                best = d;
+                best_load = load;
+            }
+        }
+        assigned[best]++;
+        result.push_back(backends[best]);
+    }
+    return result;
+}
@@ -0,0 +1,94 @@
+#include "preprocessor.h"
+
+Preprocessor::Preprocessor(PreprocessFn fn, const PreprocessCfg& cfg)
+    : fn_(std::move(fn))
+    , cfg_(cfg) {
+        cfg_.max_pending = std::max<size_t>(cfg_.max_pending, 1);
+    }
+
+Preprocessor::~Preprocessor() {
+    stop();
+}
+
+void Preprocessor::start(std::function<void(size_t)> init) {
+    stop_ = false;
+    workers_.reserve(cfg_.num_workers);
+    for (size_t i = 0; i < cfg_.num_workers; i++) {
+        workers_.emplace_back(&Preprocessor::loop, this, i, init);
+    }
+    INFO_LOG("Preprocessor started, %zu workers, max pending = %zu, %s when full",
+             cfg_.num_workers, cfg_.max_pending, cfg_.shed ? "shed" : "block");
+}
+
+bool Preprocessor::submit(std::any arg, Sink sink) {
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (pending_ >= cfg_.max_pending) {
+            if (cfg_.shed) {
+                shed_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            slot_cond_.wait(lock, [this] { return pending_ < cfg_.max_pending; });
+        }
+        pending_++;
+        if (!workers_.empty()) {
+            jobs_.push_back({std::move(arg), std::move(sink)});
+            job_cond_.notify_one();
+            return true;
+        }
+    }
+    // 没有worker时直接在调用线程上执行
+    Job job{std::move(arg), std::move(sink)};
+    run(job);
+    return true;
+}
+
+void Preprocessor::release() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        assert(pending_ > 0);
+        pending_--;
+    }
+    slot_cond_.notify_one();
+}
+
+void Preprocessor::run(Job& job) {
+    auto bytes = fn_(job.arg);
+    if (bytes.empty()) {
+        ERROR_LOG("Preprocess fail, request dropped");
+        release();
+        return;
+    }
+    job.sink(std::move(bytes));
+}
+
+void Preprocessor::loop(size_t index, std::function<void(size_t)> init) {
+    if (init) {
+        init(index);
+    }
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            job_cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        run(job);
+    }
+}
+
+void Preprocessor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    job_cond_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+    workers_.clear();
+}
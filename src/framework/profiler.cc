@@ -0,0 +1,220 @@
+#include "profiler.h"
+#include <cmath>
+#include <fstream>
+
+const char* stageName(ProfileStage stage) {
+    switch (stage) {
+        case STAGE_QUEUE: return "queue";
+        case STAGE_H2D: return "h2d";
+        case STAGE_INFER: return "infer";
+        case STAGE_D2H: return "d2h";
+        case STAGE_CALLBACK: return "callback";
+        case STAGE_TOTAL: return "total";
+        default: return "unknown";
+    }
+}
+
+LatencyHistogram::LatencyHistogram() {
+    for (auto& b : buckets_) {
+        b.store(0, std::memory_order_relaxed);
+    }
+}
+
+// 小于16直接对应前16个桶，之后每个2的幂区间16个桶
+int LatencyHistogram::bucketIndex(uint64_t ns) {
+    if (ns < kSubCount) {
+        return static_cast<int>(ns);
+    }
+    int exp = 63 - __builtin_clzll(ns);
+    if (exp > kMaxExp) {
+        return kNumBuckets - 1;
+    }
+    int sub = static_cast<int>((ns >> (exp - kSubBits)) & (kSubCount - 1));
+    return (exp - kSubBits + 1) * kSubCount + sub;
+}
+
+uint64_t LatencyHistogram::bucketMid(int index) {
+    if (index < kSubCount) {
+        return index;
+    }
+    int exp = index / kSubCount + kSubBits - 1;
+    uint64_t sub = index % kSubCount;
+    uint64_t width = 1ull << (exp - kSubBits);
+    return ((kSubCount + sub) << (exp - kSubBits)) + width / 2;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    buckets_[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(ns, std::memory_order_relaxed);
+    auto cur = max_.load(std::memory_order_relaxed);
+    while (ns > cur && !max_.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {
+    }
+}
+
+double LatencyHistogram::mean() const {
+    auto n = count();
+    return n == 0 ? 0.0 : (double)sum_.load(std::memory_order_relaxed) / (double)n;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    auto n = count();
+    if (n == 0) {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(std::ceil(p / 100.0 * (double)n));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketMid(i), max());
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& b : buckets_) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < kNumBuckets; i++) {
+        buckets_[i].fetch_add(other.buckets_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    count_.fetch_add(other.count(), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    auto m = other.max();
+    auto cur = max_.load(std::memory_order_relaxed);
+    while (m > cur && !max_.compare_exchange_weak(cur, m, std::memory_order_relaxed)) {
+    }
+}
+
+Profiler::Profiler(const ProfilerCfg& cfg, int num_executor)
+    : cfg_(cfg)
+    , start_ns_(now()) {
+        executors_.reserve(num_executor);
+        for (int i = 0; i < num_executor; i++) {
+            executors_.push_back(std::make_unique<ExecutorStats>());
+        }
+    }
+
+void Profiler::record(int executor_id, const TaskTimes& t) {
+    assert(executor_id >= 0 && executor_id < (int)executors_.size());
+    auto& stats = *executors_[executor_id];
+    auto span = [&stats](ProfileStage stage, uint64_t begin, uint64_t end) {
+        if (begin != 0 && end >= begin) {
+            stats.stages[stage].record(end - begin);
+        }
+    };
+    span(STAGE_QUEUE, t.enqueue, t.dequeue);
+    span(STAGE_H2D, t.h2d_begin, t.h2d_end);
+    span(STAGE_INFER, t.h2d_end, t.infer_end);
+    span(STAGE_D2H, t.infer_end, t.d2h_end);
+    span(STAGE_CALLBACK, t.d2h_end, t.cb_end);
+    span(STAGE_TOTAL, t.enqueue != 0 ? t.enqueue : t.dequeue, t.cb_end);
+
+    if (cfg_.format == "chrome" && trace_count_.fetch_add(1, std::memory_order_relaxed) < cfg_.max_trace_events) {
+        std::lock_guard<std::mutex> lock(stats.trace_lock);
+        stats.traces.push_back(t);
+    }
+}
+
+void Profiler::stageJson(std::string& out, const LatencyHistogram* stages, double seconds) const {
+    char buf[256];
+    out += "{";
+    for (int s = 0; s < STAGE_NUM; s++) {
+        auto& h = stages[s];
+        snprintf(buf, sizeof(buf),
+                 "%s\"%s\":{\"count\":%lu,\"qps\":%.2f,\"mean_us\":%.2f,\"p50_us\":%.2f,\"p90_us\":%.2f,"
+                 "\"p99_us\":%.2f,\"p999_us\":%.2f,\"max_us\":%.2f}",
+                 s == 0 ? "" : ",", stageName((ProfileStage)s), h.count(),
+                 seconds > 0 ? h.count() / seconds : 0.0, h.mean() / 1e3,
+                 h.percentile(50) / 1e3, h.percentile(90) / 1e3, h.percentile(99) / 1e3,
+                 h.percentile(99.9) / 1e3, h.max() / 1e3);
+        out += buf;
+    }
+    out += "}";
+}
+
+std::string Profiler::toJson() const {
+    double seconds = (now() - start_ns_) / 1e9;
+    LatencyHistogram all[STAGE_NUM];
+    std::string out = "{\"duration_s\":" + std::to_string(seconds) + ",\"executors\":[";
+    for (size_t i = 0; i < executors_.size(); i++) {
+        auto& stages = executors_[i]->stages;
+        for (int s = 0; s < STAGE_NUM; s++) {
+            all[s].merge(stages[s]);
+        }
+        out += i == 0 ? "" : ",";
+        out += "{\"id\":" + std::to_string(i) + ",\"stages\":";
+        stageJson(out, stages, seconds);
+        out += "}";
+    }
+    out += "],\"all\":";
+    stageJson(out, all, seconds);
+    out += "}\n";
+    return out;
+}
+
+// Chrome trace event格式，可直接用chrome://tracing或Perfetto打开
+std::string Profiler::toChromeTrace() const {
+    std::string out = "{\"traceEvents\":[";
+    char buf[256];
+    bool first = true;
+    for (size_t i = 0; i < executors_.size(); i++) {
+        std::lock_guard<std::mutex> lock(executors_[i]->trace_lock);
+        for (auto& t : executors_[i]->traces) {
+            uint64_t points[][2] = {
+                {t.enqueue, t.dequeue}, {t.h2d_begin, t.h2d_end}, {t.h2d_end, t.infer_end},
+                {t.infer_end, t.d2h_end}, {t.d2h_end, t.cb_end},
+            };
+            for (int s = 0; s < STAGE_TOTAL; s++) {
+                auto begin = points[s][0], end = points[s][1];
+                if (begin == 0 || end < begin) {
+                    continue;
+                }
+                snprintf(buf, sizeof(buf),
+                         "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                         first ? "" : ",\n", stageName((ProfileStage)s), i,
+                         (begin - start_ns_) / 1e3, (end - begin) / 1e3);
+                out += buf;
+                first = false;
+            }
+        }
+    }
+    out += "]}\n";
+    return out;
+}
+
+Result Profiler::dump() {
+    double seconds = (now() - start_ns_) / 1e9;
+    LatencyHistogram all[STAGE_NUM];
+    for (auto& e : executors_) {
+        for (int s = 0; s < STAGE_NUM; s++) {
+            all[s].merge(e->stages[s]);
+        }
+    }
+    INFO_LOG("Profiler: %lu tasks in %.3f s, qps %.2f", all[STAGE_TOTAL].count(), seconds,
+             seconds > 0 ? all[STAGE_TOTAL].count() / seconds : 0.0);
+    for (int s = 0; s < STAGE_NUM; s++) {
+        auto& h = all[s];
+        INFO_LOG("Profiler: %-8s p50 %9.1f us  p90 %9.1f us  p99 %9.1f us  p999 %9.1f us",
+                 stageName((ProfileStage)s), h.percentile(50) / 1e3, h.percentile(90) / 1e3,
+                 h.percentile(99) / 1e3, h.percentile(99.9) / 1e3);
+    }
+
+    std::ofstream file(cfg_.output);
+    if (!file) {
+        ERROR_LOG("Profiler can not open %s", cfg_.output.c_str());
+        return FAIL;
+    }
+    file << (cfg_.format == "chrome" ? toChromeTrace() : toJson());
+    INFO_LOG("Profiler result written to %s", cfg_.output.c_str());
+    return SUCCESS;
+}
@@ -1,30 +1,82 @@
 #include "common.h"
 #include "session.h"
 #include <yaml-cpp/yaml.h>
+#include <fstream>
 
 Session::Session(const std::string& yaml_file) {
     monitor_ = Monitor::getInstance();
 
     scfg_ = loadConfig(yaml_file);
-    for (auto d : scfg_.devices) {
-        if (d == "lynxi") {
-            backends_.push_back(monitor_->getBackend(BACKEND_LYNXI));
-        } else if (d == "dummy") {
-            backends_.push_back(monitor_->getBackend(BACKEND_DUMMY));
+    for (auto& d : scfg_.devices) {
+        Backend* backend = nullptr;
+        if (d.type == "lynxi") {
+            backend = monitor_->getBackend(BACKEND_LYNXI, d.id);
+        } else if (d.type == "dummy") {
+            backend = monitor_->getBackend(BACKEND_DUMMY, d.id);
+            if (backend != nullptr) {
+                // 模型profile里的device段覆盖dummy_latency中对应的项
+                DummyModelProfile profile;
+                profile.device = scfg_.dummy_latency;
+                DummyModelProfile::load(scfg_.model_path, profile);
+                static_cast<Dummy*>(backend)->setLatency(profile.device);
+                static_cast<Dummy*>(backend)->setBatchSize(scfg_.dummy_batch_size);
+                static_cast<Dummy*>(backend)->setSpeed(d.speed);
+                for (auto& [path, cost] : scfg_.dummy_models) {
+                    static_cast<Dummy*>(backend)->setModelCost(path, cost);
+                }
+                auto script = scfg_.dummy_telemetry.find(d.id);
+                if (script != scfg_.dummy_telemetry.end()) {
+                    static_cast<Dummy*>(backend)->setTelemetryScript(script->second);
+                }
+            }
+        } else if (d.type == "cpu") {
+            backend = monitor_->getBackend(BAKCEND_CPU, d.id);
+            if (backend != nullptr) {
+                if (scfg_.cpu_threads > 0) {
+                    static_cast<Cpu*>(backend)->setNumThreads(scfg_.cpu_threads);
+                }
+                backend->init();
+            }
         } else {
+            ERROR_LOG("unknown device type %s", d.type.c_str());
             assert(0);
         }
+        if (backend == nullptr) {
+            ERROR_LOG("skip device %s:%d", d.type.c_str(), d.id);
+            continue;
+        }
+        backends_.push_back(backend);
+        weights_.push_back(d.weight);
+        numa_nodes_.push_back(d.numa);
     }
-    tq_ = std::make_unique<TaskQueue>();
-
+    assert(!backends_.empty());
     num_executor_ = scfg_.num_executor;
     num_task_ = scfg_.num_task;
     model_path_ = scfg_.model_path;
-    executors_.reserve(num_executor_);
-    auto output_dtype = stringToDataType(scfg_.outputs[0].dtype);
-    for (int i = 0; i < num_executor_; i++) {
-        // 暂时先都分配到第一个后端上
-        executors_.emplace_back(std::make_unique<Executor>(model_path_, backends_[0], tq_.get(), i, output_dtype));
+
+    if (scfg_.model_manager) {
+        for (auto backend : backends_) {
+            if (managers_.count(backend) == 0) {
+                managers_[backend] = std::make_unique<ModelManager>(backend, scfg_.manager);
+            }
+        }
+    }
+
+    if (scfg_.admission) {
+        admission_ = std::make_unique<AdmissionControl>(scfg_.admit, [this] { return tq_->size(); });
+    }
+
+    // 配置有错时不构造，ImagePipeline只用assert检查参数
+    if (scfg_.image_pipeline && scfg_.error.empty()) {
+        image_pipeline_ = std::make_unique<ImagePipeline>(scfg_.image);
+        preprocess_fn_ = image_pipeline_->makePreprocessFn();
+    }
+
+    if (scfg_.batching) {
+        // 需要模型的batch大小，先在后端上加载一次，句柄一直持有，executor加载时直接复用
+        model_ = backends_[0]->acquireModel(model_path_);
+        assert(model_ != nullptr && model_->getInfo() != nullptr);
+        batch_size_ = model_->getInfo()->getBatchSize();
     }
 }
 
@@ -51,76 +103,479 @@ const std::string& image_path) {
 */
 
 
-SessionOut Session::Run() {
-    assert(monitor_ != nullptr);
+Result Session::start() {
+    std::lock_guard<std::mutex> lock(state_lock_);
+    if (running_) {
+        return SUCCESS;
+    }
+    if (!scfg_.error.empty()) {
+        ERROR_LOG("invalid session config: %s", scfg_.error.c_str());
+        return FAIL;
+    }
+    // 预处理产出的是一段字节，makeInputs只能按一个输入张量组装
+    if (preprocess_fn_ && scfg_.inputs.size() != 1) {
+        ERROR_LOG("preprocess needs exactly one model input, %zu configured", scfg_.inputs.size());
+        return FAIL;
+    }
+    // 开启autoscale时executor数在[min, max]之间变化，队列分片和profiler按上限分配
+    int initial = num_executor_;
+    int max_executors = num_executor_;
+    if (scfg_.autoscale) {
+        initial = std::min(std::max(num_executor_, scfg_.scale.min_executors), scfg_.scale.max_executors);
+        max_executors = std::max(initial, scfg_.scale.max_executors);
+    }
+    // submit按配置的inputs校验请求，单个样本每个输入张量的字节数
+    input_bytes_.clear();
+    for (auto& in : scfg_.inputs) {
+        input_bytes_.push_back(Tensor::view(nullptr, in.shape, stringToDataType(in.dtype)).size());
+    }
+    // TaskQueue关闭后不能复用，每次start重新创建
+    tq_ = makeTaskQueue(scfg_.scheduler, max_executors);
+    executors_.clear();
+    exited_busy_ns_ = 0;
+    auto placement = Placement::assign(backends_, weights_, initial, scfg_.device_policy);
+    if (scfg_.profiler.enable) {
+        profiler_ = std::make_unique<Profiler>(scfg_.profiler, max_executors);
+    }
+    if (scfg_.batching) {
+        batcher_ = std::make_unique<Batcher>(tq_.get(), batch_size_, scfg_.batcher);
+        batcher_->start();
+    }
+    // 线程放置在启动前全部算好，一次打印出来
+    exec_placer_ = std::make_unique<ThreadPlacer>("exec", scfg_.affinity.executors, scfg_.affinity);
+    std::vector<ThreadPlacement> exec_plans;
+    for (int i = 0; i < initial; i++) {
+        exec_plans.push_back(planExecutor(i, placement[i]));
+    }
+    ThreadPlacer::logPlan(exec_plans);
+    if (scfg_.governor) {
+        // executor启动时attach，先让governor知道有哪些设备
+        governor_ = std::make_unique<Governor>(scfg_.govern);
+        governor_->start();
+    }
+    if (preprocess_fn_) {
+        ThreadPlacer pre_placer("pre", scfg_.affinity.preprocess, scfg_.affinity);
+        auto pre_plans = std::make_shared<std::vector<ThreadPlacement>>();
+        for (size_t i = 0; i < scfg_.preprocess.num_workers; i++) {
+            pre_plans->push_back(pre_placer.plan(i));
+        }
+        ThreadPlacer::logPlan(*pre_plans);
+        preprocessor_ = std::make_unique<Preprocessor>(preprocess_fn_, scfg_.preprocess);
+        preprocessor_->start([pre_plans](size_t i) { ThreadPlacer::apply((*pre_plans)[i]); });
+    }
 
-    for (int i = 0; i < num_task_; i++) {
-        std::vector<uint8_t> tensor_bytes;
-        if (preprocess_fn_) {
-            INFO_LOG("Session is preprocessing now");
-            tensor_bytes = preprocess_fn_(scfg_.input_file);
-            assert(tensor_bytes.size() > 0);
-            INFO_LOG("Session preprocess down");
-        }
-
-        INFO_LOG("Session Create Task[%d] now", i);
-        // TODO: 这里假设了模型只有一个输入张量
-        std::vector<uint32_t> in_shape = scfg_.inputs[0].shape;
-        auto in_dtype = scfg_.inputs[0].dtype;
-        INFO_LOG("The input shape is:");
-        for (auto x : in_shape) {
-            printf("%d ", x);
-        }
-        printf("\n");
-        Task task{std::vector<Tensor>{{tensor_bytes, in_shape, stringToDataType(in_dtype)}}, 
-                [this](std::vector<Tensor>&& outputs) {
-                    outputs_.emplace_back(std::move(outputs));
-                    // 每完成一个任务，计数器减一
-                    if (task_counter_.fetch_sub(1) == 1) {
-                        tq_->shutdown();  // 所有任务都处理完了
-                    }
-                }
-            };
-        task_counter_.fetch_add(1);
-        tq_->push(task);
+    {
+        std::lock_guard<std::mutex> scale_lock(scale_lock_);
+        for (int i = 0; i < initial; i++) {
+            addExecutor(i, placement[i], exec_plans[i]);
+        }
     }
-    
+    if (scfg_.autoscale) {
+        Autoscaler::Hooks hooks;
+        hooks.queue_depth = [this] { return tq_->size(); };
+        hooks.live = [this] { return liveExecutors(); };
+        hooks.scale_up = [this] { return scaleUp(); };
+        hooks.scale_down = [this] { return scaleDown(); };
+        hooks.busy_ns = [this] {
+            std::lock_guard<std::mutex> lock(scale_lock_);
+            uint64_t busy = exited_busy_ns_;
+            for (auto& w : executors_) {
+                busy += w->executor->busyNs();
+            }
+            return busy;
+        };
+        autoscaler_ = std::make_unique<Autoscaler>(scfg_.scale, std::move(hooks));
+        autoscaler_->start();
+    }
+    if (scfg_.telemetry) {
+        startTelemetry();
+    }
+    running_ = true;
+    INFO_LOG("Session started with %d executors", initial);
+    return SUCCESS;
+}
 
-    std::vector<std::thread> threads;
-    threads.reserve(num_executor_);
+void Session::startTelemetry() {
+    auto telemetry = Telemetry::getInstance();
+    telemetry->describe("infer_queue_depth", METRIC_GAUGE, "Tasks waiting in the TaskQueue");
+    telemetry->describe("infer_inflight_tasks", METRIC_GAUGE, "Submitted tasks whose callback has not returned");
+    telemetry->describe("infer_executors", METRIC_GAUGE, "Live executor threads");
+    telemetry->describe("infer_executor_busy_seconds_total", METRIC_COUNTER, "Time the executor spent on tasks");
+    telemetry->describe("infer_executor_tasks_total", METRIC_COUNTER, "Tasks completed by the executor");
+    // 多个session同时运行时用模型名区分
+    std::string model = model_path_.substr(model_path_.find_last_of('/') + 1);
+    collector_id_ = telemetry->addCollector([this, model](const Telemetry::Emit& emit) {
+        MetricLabels labels{{"model", model}};
+        emit("infer_queue_depth", labels, tq_->size());
+        emit("infer_inflight_tasks", labels, inflight_.load());
+        emit("infer_executors", labels, liveExecutors());
+        std::lock_guard<std::mutex> lock(scale_lock_);
+        for (auto& w : executors_) {
+            MetricLabels exec_labels{{"model", model}, {"executor", std::to_string(w->executor->getId())}};
+            emit("infer_executor_busy_seconds_total", exec_labels, w->executor->busyNs() / 1e9);
+            emit("infer_executor_tasks_total", exec_labels, w->executor->tasksDone());
+        }
+    });
+    own_telemetry_ = !telemetry->running();
+    if (telemetry->start(scfg_.metrics) != SUCCESS) {
+        WARN_LOG("telemetry exporter failed to start, samples are still kept in memory");
+    }
+}
 
-    for (int i = 0; i < num_executor_; i++) {
-        threads.emplace_back([this, i]() {
-            auto res = executors_[i]->Execute();
-            if (res != SUCCESS) {
-                ERROR_LOG("Executor [%d] failed", i);
-            }
-        });
+ThreadPlacement Session::planExecutor(int id, Backend* backend) {
+    // 按numa绑核时executor放到它所在设备的节点
+    size_t dev = std::find(backends_.begin(), backends_.end(), backend) - backends_.begin();
+    int node = numa_nodes_[dev] >= 0 ? numa_nodes_[dev] : (int)dev % CpuTopology::get().numNodes();
+    return exec_placer_->plan(id, node);
+}
+
+void Session::addExecutor(int id, Backend* backend, const ThreadPlacement& plan) {
+    auto worker = std::make_unique<ExecutorThread>();
+    worker->executor = std::make_unique<Executor>(model_path_, backend, tq_.get(), id,
+                                                  stringToDataType(scfg_.outputs[0].dtype),
+                                                  scfg_.pipeline_depth, profiler_.get());
+    auto it = managers_.find(backend);
+    if (it != managers_.end()) {
+        worker->executor->setModelManager(it->second.get());
     }
-    for (auto& t : threads) {
-        t.join();
+    worker->executor->setGovernor(governor_.get());
+    auto w = worker.get();
+    worker->thread = std::thread([this, w, id, plan]() {
+        ThreadPlacer::apply(plan);
+        auto res = w->executor->Execute();
+        if (res != SUCCESS) {
+            ERROR_LOG("Executor [%d] failed", id);
+        }
+        w->exited.store(true);
+        if (w->executor->retired()) {
+            retiring_.fetch_sub(1);
+        }
+    });
+    executors_.push_back(std::move(worker));
+}
+
+int Session::liveExecutors() {
+    std::lock_guard<std::mutex> lock(scale_lock_);
+    int alive = std::count_if(executors_.begin(), executors_.end(), [](auto& w) { return !w->exited.load(); });
+    return alive - retiring_.load();
+}
+
+bool Session::scaleUp() {
+    std::lock_guard<std::mutex> lock(scale_lock_);
+    // 回收已经退出的executor，空出编号
+    for (auto it = executors_.begin(); it != executors_.end();) {
+        if ((*it)->exited.load()) {
+            (*it)->thread.join();
+            exited_busy_ns_ += (*it)->executor->busyNs();
+            it = executors_.erase(it);
+        } else {
+            ++it;
+        }
     }
+    std::vector<bool> used(scfg_.scale.max_executors, false);
+    std::map<Backend*, int> per_backend;
+    for (auto& w : executors_) {
+        used[w->executor->getId()] = true;
+        per_backend[w->executor->getBackend()]++;
+    }
+    int id = std::find(used.begin(), used.end(), false) - used.begin();
+    if (id >= (int)used.size()) {
+        return false;
+    }
+    // 放到按weight折算后executor最少的设备上
+    size_t best = 0;
+    for (size_t i = 1; i < backends_.size(); i++) {
+        if (per_backend[backends_[i]] / weights_[i] < per_backend[backends_[best]] / weights_[best]) {
+            best = i;
+        }
+    }
+    auto plan = planExecutor(id, backends_[best]);
+    ThreadPlacer::logPlan({plan});
+    addExecutor(id, backends_[best], plan);
+    return true;
+}
 
-    // TODO:添加计算每个exeutor执行时间的代码
-    INFO_LOG("Session Run over, output size = %ld", outputs_.size());
-    // 返回结果
-    
-    SessionOut ret;
-    ret.reserve(outputs_.size());
+bool Session::scaleDown() {
+    // 任意一个取到退出任务的executor处理完在途任务后退出，释放stream和设备内存
+    retiring_.fetch_add(1);
+    Task task;
+    task.retire = true;
+    tq_->push(std::move(task));
+    return true;
+}
 
-    for (auto result : outputs_) {
-        // result是一个任务的所有输出张量
-        std::vector<std::vector<uint8_t>> task_out;      
-        task_out.reserve(result.size());
-        for (auto tensor : result) {
-            task_out.emplace_back(tensor.asVector());
+bool Session::checkInputs(const std::vector<Tensor>& inputs, const SubmitOptions& opts) const {
+    // 其他模型的输入和配置无关，交给executor检查
+    if (input_bytes_.empty() || (!opts.model.empty() && opts.model != model_path_)) {
+        return true;
+    }
+    if (inputs.size() != input_bytes_.size()) {
+        WARN_LOG("Session: request rejected, %zu input tensors, model needs %zu", inputs.size(), input_bytes_.size());
+        return false;
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        // 合并batch时每个请求是一个样本；否则可以是整数个样本，总大小由executor按模型的batch检查
+        size_t size = inputs[i].size(), sample = input_bytes_[i];
+        bool ok = batcher_ ? size == sample : (sample == 0 ? size == 0 : size > 0 && size % sample == 0);
+        if (!ok) {
+            WARN_LOG("Session: request rejected, input[%zu] is %zu bytes, sample is %zu bytes", i, size, sample);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Session::submit(std::vector<Tensor> inputs, TaskCallback cb, const SubmitOptions& opts) {
+    assert(running_);
+    if (!checkInputs(inputs, opts)) {
+        return false;
+    }
+    if (admission_ && !admission_->acquire()) {
+        DEBUG_LOG("Session: request rejected, %zu inflight", admission_->inflight());
+        return false;
+    }
+    enqueue(std::move(inputs), std::move(cb), opts);
+    return true;
+}
+
+void Session::enqueue(std::vector<Tensor> inputs, TaskCallback cb, const SubmitOptions& opts) {
+    inflight_.fetch_add(1);
+    // autoscaler按窗口内的端到端延迟决策
+    uint64_t begin = autoscaler_ ? Profiler::now() : 0;
+    Task task{std::move(inputs), [this, cb = std::move(cb), begin](std::vector<Tensor>&& outputs) {
+        if (begin != 0) {
+            autoscaler_->record(Profiler::now() - begin);
+        }
+        cb(std::move(outputs));
+        taskDone();
+    }};
+    if (opts.on_drop) {
+        task.on_drop = [this, on_drop = opts.on_drop](TaskStatus status) {
+            on_drop(status);
+            taskDone();
+        };
+    }
+    task.priority = opts.priority;
+    task.shard = opts.executor;
+    if (profiler_ || opts.timeout_us > 0) {
+        task.times.enqueue = Profiler::now();
+    }
+    if (opts.timeout_us > 0) {
+        task.deadline = task.times.enqueue + (uint64_t)opts.timeout_us * 1000;
+    }
+    if (!opts.model.empty() && opts.model != model_path_) {
+        // 只有默认模型的请求可以合并成batch
+        task.model = opts.model;
+        tq_->push(std::move(task));
+    } else if (batcher_) {
+        batcher_->submit(std::move(task));
+    } else {
+        tq_->push(std::move(task));
+    }
+}
+
+bool Session::submitRaw(std::any arg, TaskCallback cb) {
+    assert(running_ && preprocessor_ != nullptr);
+    // 预处理的名额在下游任务完成(回调返回)后才归还
+    return preprocessor_->submit(std::move(arg), [this, cb = std::move(cb)](std::vector<uint8_t>&& bytes) {
+        // 已经做完预处理的请求不再拒绝，在预处理线程上等名额，由Preprocessor向提交方反压
+        if (admission_) {
+            admission_->acquire(true);
+        }
+        enqueue(makeInputs(std::move(bytes)), [this, cb](std::vector<Tensor>&& outputs) {
+            cb(std::move(outputs));
+            preprocessor_->release();
+        }, {});
+    });
+}
+
+std::vector<Tensor> Session::makeInputs(std::vector<uint8_t>&& bytes) const {
+    // start已经保证配置了预处理时只有一个输入
+    auto& in = scfg_.inputs[0];
+    auto dtype = stringToDataType(in.dtype);
+    if (!in.host_dtype.empty() && in.host_dtype != in.dtype) {
+        Tensor host(std::move(bytes), in.shape, stringToDataType(in.host_dtype));
+        return std::vector<Tensor>{host.convertTo(dtype, in.quant)};
+    }
+    return std::vector<Tensor>{{std::move(bytes), in.shape, dtype}};
+}
+
+std::future<std::vector<Tensor>> Session::submit(std::vector<Tensor> inputs, const SubmitOptions& opts) {
+    // std::function要求可拷贝，promise放在shared_ptr里
+    auto promise = std::make_shared<std::promise<std::vector<Tensor>>>();
+    auto future = promise->get_future();
+    if (!submit(std::move(inputs), [promise](std::vector<Tensor>&& outputs) {
+        promise->set_value(std::move(outputs));
+    }, opts)) {
+        promise->set_value({});
+    }
+    return future;
+}
+
+void Session::taskDone() {
+    if (admission_) {
+        admission_->release();
+    }
+    if (inflight_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(drain_lock_);
+        drain_cond_.notify_all();
+    }
+}
+
+void Session::drain() {
+    std::unique_lock<std::mutex> lock(drain_lock_);
+    drain_cond_.wait(lock, [this] { return inflight_.load() == 0; });
+}
+
+void Session::stop() {
+    std::lock_guard<std::mutex> lock(state_lock_);
+    if (!running_) {
+        return;
+    }
+    // 先让预处理中的请求全部进入TaskQueue，drain才能等到它们
+    if (preprocessor_) {
+        preprocessor_->stop();
+        if (preprocessor_->shedCount() > 0) {
+            WARN_LOG("Preprocessor shed %lu requests", preprocessor_->shedCount());
+        }
+    }
+    drain();
+    if (autoscaler_) {
+        autoscaler_->stop();
+    }
+    // 停掉后被限流的executor不再阻塞，能取到队列关闭的通知
+    if (governor_) {
+        governor_->stop();
+    }
+    preprocessor_.reset();
+    if (batcher_) {
+        batcher_->stop();
+    }
+    tq_->shutdown();
+    {
+        std::lock_guard<std::mutex> scale_lock(scale_lock_);
+        for (auto& w : executors_) {
+            w->thread.join();
+        }
+        retiring_.store(0);
+    }
+    if (collector_id_ >= 0) {
+        // 最后采一次，导出的计数包含全部已完成的任务
+        auto telemetry = Telemetry::getInstance();
+        telemetry->sampleOnce();
+        if (own_telemetry_) {
+            telemetry->stop();
+        }
+        telemetry->removeCollector(collector_id_);
+        collector_id_ = -1;
+    }
+    running_ = false;
+    if (admission_) {
+        admission_->logStats();
+    }
+    if (governor_) {
+        governor_->logStats();
+        if (!scfg_.govern.events_output.empty()) {
+            std::ofstream file(scfg_.govern.events_output);
+            file << governor_->toJson();
+        }
+        governor_.reset();
+    }
+    if (auto dq = dynamic_cast<DeadlineQueue*>(tq_.get())) {
+        dq->logStats();
+        if (!scfg_.scheduler.stats_output.empty()) {
+            std::ofstream file(scfg_.scheduler.stats_output);
+            file << dq->toJson();
         }
-        ret.push_back(task_out);
     }
+    if (profiler_) {
+        profiler_->dump();
+        profiler_.reset();
+    }
+    INFO_LOG("Session stopped");
+}
+
+SessionOut Session::Run() {
+    assert(monitor_ != nullptr);
+    if (!preprocess_fn_ && scfg_.inputs.size() != 1) {
+        ERROR_LOG("Run builds inputs from one configured input, %zu configured", scfg_.inputs.size());
+        return {};
+    }
+    if (start() != SUCCESS) {
+        ERROR_LOG("Session start fail");
+        return {};
+    }
+
+    // 超过max_outputs的输出做完后处理就释放，长时间运行时内存不增长
+    std::atomic<uint64_t> discarded{0};
+    auto collect = [this, &discarded](std::vector<Tensor>&& outputs) {
+        if (postprocess_fn_) {
+            postprocess_fn_(outputs);
+        }
+        std::lock_guard<std::mutex> lock(outputs_lock_);
+        if (scfg_.max_outputs > 0 && outputs_.size() >= scfg_.max_outputs) {
+            discarded.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        outputs_.emplace_back(std::move(outputs));
+    };
+    for (int i = 0; i < num_task_; i++) {
+        DEBUG_LOG("Session Create Task[%d] now", i);
+        if (preprocess_fn_) {
+            // 预处理在Preprocessor的线程池上执行，和推理重叠
+            submitRaw(scfg_.input_file, collect);
+        } else {
+            // 批处理接口不丢请求，名额不够时总是等待
+            if (admission_) {
+                admission_->acquire(true);
+            }
+            enqueue(makeInputs({}), collect, {});
+        }
+    }
+    stop();
+
+    // 每个executor各阶段的耗时在profiling开启时由stop()输出
+    INFO_LOG("Session Run over, output size = %ld, discarded %lu", outputs_.size(), discarded.load());
+    for (auto backend : backends_) {
+        auto stats = backend->getMemoryPool()->getStats();
+        INFO_LOG("MemoryPool[%d]: hit rate %.2f (hits %lu, misses %lu), held %lu bytes, in use %lu bytes",
+                 backend->getDeviceId(), stats.hitRate(), stats.hits, stats.misses, stats.bytes_held, stats.bytes_in_use);
+    }
+    // 返回结果，直接把输出交给调用方
+    SessionOut ret = std::move(outputs_);
+    outputs_.clear();
     return ret;
     // 后处理？
 }
 
+// 设备可以写成 "dummy"、"lynxi:1"，或者 {type: dummy, id: 1, weight: 2, speed: 0.5}
+static DeviceCfg parseDevice(const YAML::Node& node) {
+    DeviceCfg dc;
+    if (node.IsScalar()) {
+        auto str = node.as<std::string>();
+        auto pos = str.find(':');
+        dc.type = str.substr(0, pos);
+        if (pos != std::string::npos) {
+            dc.id = std::stoi(str.substr(pos + 1));
+        }
+        return dc;
+    }
+    dc.type = node["type"].as<std::string>();
+    if (node["id"]) {
+        dc.id = node["id"].as<int>();
+    }
+    if (node["weight"]) {
+        dc.weight = node["weight"].as<float>();
+    }
+    if (node["speed"]) {
+        dc.speed = node["speed"].as<double>();
+    }
+    if (node["numa"]) {
+        dc.numa = node["numa"].as<int>();
+    }
+    return dc;
+}
+
 SessionCfg Session::loadConfig(const std::string& yaml_file) {
     YAML::Node config = YAML::LoadFile(yaml_file);
     SessionCfg sc;
@@ -131,7 +586,28 @@ SessionCfg Session::loadConfig(const std::string& yaml_file) {
     sc.input_file   = config["input_file"].as<std::string>();
 
     for (auto d : config["devices"]) {
-        sc.devices.push_back(d.as<std::string>());
+        sc.devices.push_back(parseDevice(d));
+        // scaleUp和least_loaded放置按 executor数/weight 比较，weight为0时得到inf/NaN
+        if (!(sc.devices.back().weight > 0.0f)) {
+            sc.error = "device " + sc.devices.back().type + ":" + std::to_string(sc.devices.back().id) +
+                       " weight must be positive";
+        }
+        // dummy设备可以带一段温度/显存脚本: telemetry: [{at_ms: 0, temp: 60}, {at_ms: 500, temp: 93, memory: 0.5}]
+        if (d.IsMap() && d["telemetry"]) {
+            auto& script = sc.dummy_telemetry[sc.devices.back().id];
+            for (auto p : d["telemetry"]) {
+                DummyTelemetryPoint point;
+                point.at_ms = p["at_ms"].as<uint32_t>();
+                point.temperature = p["temp"] ? p["temp"].as<int32_t>() : 0;
+                if (p["memory"]) {
+                    point.memory_rate = p["memory"].as<double>();
+                }
+                script.push_back(point);
+            }
+        }
+    }
+    if (config["device_policy"]) {
+        sc.device_policy = stringToPlacementPolicy(config["device_policy"].as<std::string>());
     }
 
     if (config["inputs"]) {
@@ -144,6 +620,15 @@ SessionCfg Session::loadConfig(const std::string& yaml_file) {
             if (item["dtype"]) {
                 tc.dtype = item["dtype"].as<std::string>();
             }
+            if (item["host_dtype"]) {
+                tc.host_dtype = item["host_dtype"].as<std::string>();
+            }
+            if (item["quant_scale"]) {
+                tc.quant.scale = item["quant_scale"].as<float>();
+            }
+            if (item["zero_point"]) {
+                tc.quant.zero_point = item["zero_point"].as<int>();
+            }
             sc.inputs.push_back(tc);
         }
     }
@@ -158,8 +643,283 @@ SessionCfg Session::loadConfig(const std::string& yaml_file) {
             if (item["dtype"]) {
                 tc.dtype = item["dtype"].as<std::string>();
             }
+            if (item["quant_scale"]) {
+                tc.quant.scale = item["quant_scale"].as<float>();
+            }
+            if (item["zero_point"]) {
+                tc.quant.zero_point = item["zero_point"].as<int>();
+            }
             sc.outputs.push_back(tc);
         }
     }
+    if (config["pipeline_depth"]) {
+        sc.pipeline_depth = std::max(1, config["pipeline_depth"].as<int>());
+    }
+
+    if (auto batching = config["batching"]) {
+        sc.batching = true;
+        if (batching["max_batch_delay_us"]) {
+            sc.batcher.max_batch_delay_us = batching["max_batch_delay_us"].as<uint32_t>();
+        }
+        for (auto size : batching["preferred_batch_sizes"]) {
+            sc.batcher.preferred_batch_sizes.push_back(size.as<uint32_t>());
+        }
+    }
+
+    if (auto log = config["logging"]) {
+        auto logger = Logger::getInstance();
+        if (log["level"]) {
+            logger->setLevel(Logger::levelFromString(log["level"].as<std::string>()));
+        }
+        if (log["async"]) {
+            logger->setAsync(log["async"].as<bool>());
+        }
+        if (log["rate_limit"]) {
+            logger->setRateLimit(log["rate_limit"].as<uint32_t>());
+        }
+    }
+
+    if (auto prof = config["profiling"]) {
+        sc.profiler.enable = prof["enable"] ? prof["enable"].as<bool>() : true;
+        if (prof["output"]) {
+            sc.profiler.output = prof["output"].as<std::string>();
+        }
+        if (prof["format"]) {
+            sc.profiler.format = prof["format"].as<std::string>();
+        }
+        if (prof["max_trace_events"]) {
+            sc.profiler.max_trace_events = prof["max_trace_events"].as<size_t>();
+        }
+    }
+
+    if (auto pre = config["preprocess"]) {
+        if (pre["num_workers"]) {
+            sc.preprocess.num_workers = pre["num_workers"].as<size_t>();
+        }
+        if (pre["max_pending"]) {
+            sc.preprocess.max_pending = pre["max_pending"].as<size_t>();
+        }
+        if (pre["overflow"]) {
+            sc.preprocess.shed = pre["overflow"].as<std::string>() == "shed";
+        }
+    }
+
+    if (auto img = config["image_pipeline"]) {
+        sc.image_pipeline = true;
+        auto& ic = sc.image;
+        if (img["resize_short"]) {
+            ic.resize_short = img["resize_short"].as<int>();
+        }
+        if (img["crop"]) {
+            ic.crop_h = img["crop"][0].as<int>();
+            ic.crop_w = img["crop"][1].as<int>();
+        }
+        if (img["scale"]) {
+            ic.scale = img["scale"].as<float>();
+        }
+        if (img["mean"]) {
+            ic.mean = img["mean"].as<std::vector<float>>();
+        }
+        if (img["std"]) {
+            ic.std = img["std"].as<std::vector<float>>();
+        }
+        if (ic.mean.size() != 3 || ic.std.size() != 3) {
+            sc.error = "image_pipeline mean and std need exactly 3 values";
+        } else if (std::find(ic.std.begin(), ic.std.end(), 0.0f) != ic.std.end()) {
+            sc.error = "image_pipeline std must not be 0";
+        }
+        if (img["channel_order"]) {
+            ic.to_rgb = img["channel_order"].as<std::string>() == "rgb";
+        }
+        if (img["layout"]) {
+            ic.chw = img["layout"].as<std::string>() == "chw";
+        }
+        if (img["dtype"]) {
+            auto dtype = img["dtype"].as<std::string>();
+            if (isDataTypeName(dtype)) {
+                ic.dtype = stringToDataType(dtype);
+            } else {
+                sc.error = "image_pipeline dtype " + dtype + " is not float32/float16/bfloat16/int8/uint8";
+            }
+        }
+        if (img["quant_scale"]) {
+            ic.quant_scale = img["quant_scale"].as<float>();
+        }
+    }
+
+    if (auto sched = config["scheduler"]) {
+        if (sched["policy"]) {
+            sc.scheduler.policy = sched["policy"].as<std::string>();
+        }
+        if (sched["lanes"]) {
+            sc.scheduler.lanes = sched["lanes"].as<int>();
+        }
+        if (sched["aging_ms"]) {
+            sc.scheduler.aging_ms = sched["aging_ms"].as<uint32_t>();
+        }
+        if (sched["capacity"]) {
+            sc.scheduler.capacity = sched["capacity"].as<size_t>();
+        }
+        if (sched["stats_output"]) {
+            sc.scheduler.stats_output = sched["stats_output"].as<std::string>();
+        }
+    }
+
+    if (auto adm = config["admission"]) {
+        sc.admission = true;
+        if (adm["max_inflight"]) {
+            sc.admit.max_inflight = adm["max_inflight"].as<size_t>();
+        }
+        if (adm["max_queued"]) {
+            sc.admit.max_queued = adm["max_queued"].as<size_t>();
+        }
+        if (adm["overflow"]) {
+            sc.admit.overflow = stringToOverflowPolicy(adm["overflow"].as<std::string>());
+        }
+        if (adm["timeout_ms"]) {
+            sc.admit.timeout_ms = adm["timeout_ms"].as<uint32_t>();
+        }
+    }
+    if (config["max_outputs"]) {
+        sc.max_outputs = config["max_outputs"].as<size_t>();
+    }
+
+    if (auto aff = config["affinity"]) {
+        if (aff["executors"]) {
+            sc.affinity.executors = aff["executors"].as<std::string>();
+        }
+        if (aff["preprocess"]) {
+            sc.affinity.preprocess = aff["preprocess"].as<std::string>();
+        }
+        if (aff["per_core"]) {
+            sc.affinity.per_core = aff["per_core"].as<bool>();
+        }
+        if (aff["numa_memory"]) {
+            sc.affinity.numa_memory = aff["numa_memory"].as<bool>();
+        }
+    }
+
+    if (auto gv = config["governor"]) {
+        sc.governor = true;
+        auto& c = sc.govern;
+        if (gv["interval_ms"]) {
+            c.interval_ms = gv["interval_ms"].as<uint32_t>();
+        }
+        if (gv["temp_margin"]) {
+            c.temp_margin = gv["temp_margin"].as<int32_t>();
+        }
+        if (gv["temp_critical"]) {
+            c.temp_critical = gv["temp_critical"].as<int32_t>();
+        }
+        if (gv["mem_high"]) {
+            c.mem_high = gv["mem_high"].as<double>();
+        }
+        if (gv["mem_critical"]) {
+            c.mem_critical = gv["mem_critical"].as<double>();
+        }
+        if (gv["min_depth"]) {
+            c.min_depth = gv["min_depth"].as<int>();
+        }
+        if (gv["events_output"]) {
+            c.events_output = gv["events_output"].as<std::string>();
+        }
+    }
+
+    if (auto tm = config["telemetry"]) {
+        sc.telemetry = true;
+        auto& c = sc.metrics;
+        if (tm["interval_ms"]) {
+            c.interval_ms = tm["interval_ms"].as<uint32_t>();
+        }
+        if (tm["history"]) {
+            c.history = tm["history"].as<size_t>();
+        }
+        if (tm["prometheus_file"]) {
+            c.prometheus_file = tm["prometheus_file"].as<std::string>();
+        }
+        if (tm["http_port"]) {
+            c.http_port = tm["http_port"].as<int>();
+        }
+    }
+
+    if (auto as = config["autoscale"]) {
+        sc.autoscale = true;
+        auto& c = sc.scale;
+        if (as["min_executors"]) {
+            c.min_executors = as["min_executors"].as<int>();
+        }
+        if (as["max_executors"]) {
+            c.max_executors = as["max_executors"].as<int>();
+        }
+        if (as["interval_ms"]) {
+            c.interval_ms = as["interval_ms"].as<uint32_t>();
+        }
+        if (as["queue_per_executor"]) {
+            c.queue_per_executor = as["queue_per_executor"].as<double>();
+        }
+        if (as["p99_ms"]) {
+            c.p99_ms = as["p99_ms"].as<uint32_t>();
+        }
+        if (as["low_utilization"]) {
+            c.low_utilization = as["low_utilization"].as<double>();
+        }
+        if (as["idle_ms"]) {
+            c.idle_ms = as["idle_ms"].as<uint32_t>();
+        }
+        if (as["cooldown_ms"]) {
+            c.cooldown_ms = as["cooldown_ms"].as<uint32_t>();
+        }
+    }
+
+    if (auto mm = config["model_manager"]) {
+        sc.model_manager = true;
+        if (mm["watermark"]) {
+            sc.manager.watermark = mm["watermark"].as<float>();
+        }
+        if (mm["policy"]) {
+            sc.manager.policy = stringToEvictPolicy(mm["policy"].as<std::string>());
+        }
+        if (mm["max_resident"]) {
+            sc.manager.max_resident = mm["max_resident"].as<size_t>();
+        }
+        if (mm["preload"]) {
+            sc.manager.preload = mm["preload"].as<std::vector<std::string>>();
+        }
+    }
+
+    if (config["cpu_threads"]) {
+        sc.cpu_threads = config["cpu_threads"].as<size_t>();
+    }
+
+    if (config["dummy_batch_size"]) {
+        sc.dummy_batch_size = config["dummy_batch_size"].as<size_t>();
+    }
+
+    // 不写path的一项作为默认值
+    for (auto item : config["dummy_models"]) {
+        DummyModelCost cost;
+        if (item["size_mb"]) {
+            cost.size_bytes = (uint64_t)(item["size_mb"].as<double>() * (1 << 20));
+        }
+        if (item["load_ms"]) {
+            cost.load_ms = item["load_ms"].as<uint32_t>();
+        }
+        sc.dummy_models[item["path"] ? item["path"].as<std::string>() : ""] = cost;
+    }
+
+    if (auto lat = config["dummy_latency"]) {
+        if (lat["infer_us"]) {
+            sc.dummy_latency.infer_us = lat["infer_us"].as<uint32_t>();
+        }
+        if (lat["copy_gbps"]) {
+            sc.dummy_latency.copy_gbps = lat["copy_gbps"].as<double>();
+        }
+        if (lat["max_concurrency"]) {
+            sc.dummy_latency.max_concurrency = lat["max_concurrency"].as<uint32_t>();
+        }
+        if (lat["memory_gb"]) {
+            sc.dummy_latency.memory_bytes = (uint64_t)(lat["memory_gb"].as<double>() * (1ull << 30));
+        }
+    }
     return sc;
 }
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "telemetry.h"
+#include "profiler.h"
+#include "affinity.h"
+#include <fstream>
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+std::vector<MetricSample> TimeSeries::samples() const {
+    std::vector<MetricSample> out;
+    out.reserve(size_);
+    size_t begin = (head_ + samples_.size() - size_) % samples_.size();
+    for (size_t i = 0; i < size_; i++) {
+        out.push_back(samples_[(begin + i) % samples_.size()]);
+    }
+    return out;
+}
+
+Telemetry::~Telemetry() {
+    stop();
+}
+
+void Telemetry::describe(const std::string& name, MetricType type, const std::string& help) {
+    std::lock_guard<std::mutex> lock(lock_);
+    meta_[name] = {type, help};
+}
+
+int Telemetry::addCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(collect_lock_);
+    int id = next_id_++;
+    collectors_[id] = std::move(collector);
+    return id;
+}
+
+void Telemetry::removeCollector(int id) {
+    std::lock_guard<std::mutex> collect_lock(collect_lock_);
+    collectors_.erase(id);
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto it = series_.begin(); it != series_.end();) {
+        it = it->second.owner == id ? series_.erase(it) : std::next(it);
+    }
+}
+
+std::string Telemetry::seriesKey(const std::string& name, const MetricLabels& labels) {
+    std::string key = name + "{";
+    for (auto& [k, v] : labels) {
+        key += k + "=\"" + v + "\",";
+    }
+    key += "}";
+    return key;
+}
+
+void Telemetry::sampleOnce() {
+    std::lock_guard<std::mutex> collect_lock(collect_lock_);
+    uint64_t now = Profiler::now();
+    for (auto& [id, collector] : collectors_) {
+        int owner = id;
+        collector([this, owner, now](const std::string& name, const MetricLabels& labels, double value) {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto key = seriesKey(name, labels);
+            auto it = series_.find(key);
+            if (it == series_.end()) {
+                it = series_.emplace(key, Series{name, labels, owner, TimeSeries(cfg_.history)}).first;
+            }
+            it->second.data.push(now, value);
+        });
+    }
+}
+
+Result Telemetry::start(const TelemetryCfg& cfg) {
+    std::lock_guard<std::mutex> lock(state_lock_);
+    if (!stop_) {
+        return SUCCESS;
+    }
+    cfg_ = cfg;
+    cfg_.interval_ms = std::max<uint32_t>(1, cfg_.interval_ms);
+    stop_ = false;
+    sampler_ = std::thread(&Telemetry::loop, this);
+#ifdef __linux__
+    if (cfg_.http_port > 0) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(cfg_.http_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (listen_fd_ < 0 || bind(listen_fd_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd_, 8) != 0) {
+            ERROR_LOG("Telemetry: listen on 127.0.0.1:%d failed: %s", cfg_.http_port, strerror(errno));
+            if (listen_fd_ >= 0) {
+                close(listen_fd_);
+                listen_fd_ = -1;
+            }
+        } else {
+            http_ = std::thread(&Telemetry::serveHttp, this);
+        }
+    }
+#endif
+    INFO_LOG("Telemetry started, every %u ms, %zu samples per series%s%s", cfg_.interval_ms, cfg_.history,
+             cfg_.prometheus_file.empty() ? "" : ", file ", cfg_.prometheus_file.c_str());
+    return SUCCESS;
+}
+
+void Telemetry::stop() {
+    {
+        std::lock_guard<std::mutex> lock(state_lock_);
+        if (stop_) {
+            return;
+        }
+        stop_ = true;
+    }
+    cond_.notify_all();
+    if (sampler_.joinable()) {
+        sampler_.join();
+    }
+    if (http_.joinable()) {
+        http_.join();
+    }
+    if (!cfg_.prometheus_file.empty()) {
+        writeFile();
+    }
+#ifdef __linux__
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+#endif
+}
+
+bool Telemetry::running() const {
+    std::lock_guard<std::mutex> lock(state_lock_);
+    return !stop_;
+}
+
+void Telemetry::loop() {
+    setThreadName("telemetry");
+    std::unique_lock<std::mutex> lock(state_lock_);
+    while (!stop_) {
+        lock.unlock();
+        sampleOnce();
+        if (!cfg_.prometheus_file.empty()) {
+            writeFile();
+        }
+        lock.lock();
+        cond_.wait_for(lock, std::chrono::milliseconds(cfg_.interval_ms), [this] { return stop_; });
+    }
+}
+
+void Telemetry::writeFile() const {
+    // 先写临时文件再改名，读的一方不会看到写了一半的文件
+    auto tmp = cfg_.prometheus_file + ".tmp";
+    {
+        std::ofstream file(tmp);
+        if (!file) {
+            WARN_LOG("Telemetry: can not write %s", tmp.c_str());
+            return;
+        }
+        file << toPrometheus();
+    }
+    std::rename(tmp.c_str(), cfg_.prometheus_file.c_str());
+}
+
+void Telemetry::serveHttp() {
+#ifdef __linux__
+    setThreadName("telemetry-http");
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(state_lock_);
+            if (stop_) {
+                return;
+            }
+        }
+        // 带超时等连接，才能及时看到stop_
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        char buf[1024];
+        ssize_t n = recv(fd, buf, sizeof(buf) - 1, 0);
+        std::string request(buf, n > 0 ? n : 0);
+        std::string body, status;
+        if (request.compare(0, 12, "GET /metrics") == 0) {
+            status = "200 OK";
+            body = toPrometheus();
+        } else {
+            status = "404 Not Found";
+            body = "only GET /metrics is served\n";
+        }
+        std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" +
+                               body;
+        for (size_t sent = 0; sent < response.size();) {
+            ssize_t w = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (w <= 0) {
+                break;
+            }
+            sent += w;
+        }
+        close(fd);
+    }
+#endif
+}
+
+std::vector<SeriesSnapshot> Telemetry::snapshot(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::vector<SeriesSnapshot> out;
+    for (auto& [key, s] : series_) {
+        if (!name.empty() && s.name != name) {
+            continue;
+        }
+        auto meta = meta_.find(s.name);
+        out.push_back({s.name, s.labels, meta == meta_.end() ? METRIC_GAUGE : meta->second.type, s.data.samples()});
+    }
+    return out;
+}
+
+std::string Telemetry::toPrometheus() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::string out;
+    std::string current;
+    char value[64];
+    for (auto& [key, s] : series_) {
+        if (s.data.size() == 0) {
+            continue;
+        }
+        if (s.name != current) {
+            current = s.name;
+            auto meta = meta_.find(s.name);
+            if (meta != meta_.end()) {
+                out += "# HELP " + s.name + " " + meta->second.help + "\n";
+                out += "# TYPE " + s.name + (meta->second.type == METRIC_COUNTER ? " counter\n" : " gauge\n");
+            }
+        }
+        out += s.name;
+        if (!s.labels.empty()) {
+            out += "{";
+            for (size_t i = 0; i < s.labels.size(); i++) {
+                out += (i ? ",": "") + s.labels[i].first + "=\"" + s.labels[i].second + "\"";
+            }
+            out += "}";
+        }
+        snprintf(value, sizeof(value), " %.15g\n", s.data.last().value);
+        out += value;
+    }
+    return out;
+}
@@ -0,0 +1,98 @@
+#include "thread_pool.h"
+#include "affinity.h"
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+        workers_.emplace_back([this, i] {
+            setThreadName("pool-" + std::to_string(i));
+            loop();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+}
+
+bool ThreadPool::runChunk(Job& job) {
+    size_t idx = job.next.fetch_add(1, std::memory_order_relaxed);
+    if (idx >= job.chunks) {
+        return false;
+    }
+    size_t lo = job.begin + idx * job.grain;
+    size_t hi = std::min(job.end, lo + job.grain);
+    (*job.fn)(lo, hi);
+    if (job.done.fetch_add(1, std::memory_order_acq_rel) + 1 == job.chunks) {
+        std::lock_guard<std::mutex> lock(job.lock);
+        job.cond.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::loop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (stop_) {
+                return;
+            }
+            job = jobs_.front();
+            // 块已经领完的job不再留在队列里
+            if (job->next.load(std::memory_order_relaxed) + 1 >= job->chunks) {
+                jobs_.pop_front();
+            }
+        }
+        while (runChunk(*job)) {
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, const RangeFn& fn) {
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1 || workers_.empty()) {
+        fn(begin, end);
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->begin = begin;
+    job->end = end;
+    job->grain = grain;
+    job->chunks = chunks;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        jobs_.push_back(job);
+    }
+    if (chunks > 2) {
+        cond_.notify_all();
+    } else {
+        cond_.notify_one();
+    }
+
+    while (runChunk(*job)) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = std::find(jobs_.begin(), jobs_.end(), job);
+        if (it != jobs_.end()) {
+            jobs_.erase(it);
+        }
+    }
+    std::unique_lock<std::mutex> lock(job->lock);
+    job->cond.wait(lock, [&job] { return job->done.load(std::memory_order_acquire) == job->chunks; });
+}
@@ -0,0 +1,125 @@
+#include "work_stealing_queue.h"
+
+namespace {
+
+// 选偷取对象用，每个线程一个，不需要同步
+uint32_t fastRand() {
+    thread_local uint32_t state = std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+}  // namespace
+
+WorkStealingQueue::WorkStealingQueue(int num_workers, size_t capacity) {
+    num_workers = std::max(1, num_workers);
+    size_t per_shard = std::max<size_t>(16, capacity / num_workers);
+    for (int i = 0; i < num_workers; i++) {
+        shards_.push_back(std::make_unique<MPMCQueue<Task>>(per_shard));
+    }
+}
+
+bool WorkStealingQueue::tryPush(Task& task, size_t first) {
+    // 指定的分片满了就顺延到下一个
+    for (size_t i = 0; i < shards_.size(); i++) {
+        if (shards_[(first + i) % shards_.size()]->tryPush(task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingQueue::push(Task task) {
+    size_t first = task.shard >= 0 ? (size_t)task.shard % shards_.size()
+                                   : next_.fetch_add(1, std::memory_order_relaxed) % shards_.size();
+    int rounds = 0;
+    while (!tryPush(task, first)) {
+        // 全部分片都满，先让出CPU重试几轮，再挂起等executor取走任务
+        if (rounds++ < kRetryRounds) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(park_lock_);
+        idle_producers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        not_full_.wait(lock, [this] {
+            if (stop_.load(std::memory_order_acquire)) {
+                return true;
+            }
+            for (auto& shard : shards_) {
+                if (shard->size() < shard->capacity()) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        idle_producers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    wake(not_empty_, idle_consumers_);
+}
+
+bool WorkStealingQueue::pop(Task& task_out, int worker) {
+    size_t own = (size_t)std::max(worker, 0) % shards_.size();
+    while (true) {
+        // 先本地后偷取，都落空时让出CPU重试几轮再挂起
+        for (int i = 0; i < kRetryRounds; i++) {
+            if (shards_[own]->tryPop(task_out) || steal(own, task_out)) {
+                wake(not_full_, idle_producers_);
+                return true;
+            }
+            if (stop_.load(std::memory_order_acquire) && size() == 0) {
+                INFO_LOG("WorkStealingQueue[%zu] stopped, %lu steals in total", own, stealCount());
+                return false;
+            }
+            std::this_thread::yield();
+        }
+
+        // 挂起，idle计数和队列状态之间用seq_cst栅栏保证唤醒不丢失
+        std::unique_lock<std::mutex> lock(park_lock_);
+        idle_consumers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        not_empty_.wait(lock, [this] { return stop_.load(std::memory_order_acquire) || size() > 0; });
+        idle_consumers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool WorkStealingQueue::steal(size_t worker, Task& task_out) {
+    size_t n = shards_.size();
+    size_t start = fastRand() % n;
+    for (size_t i = 0; i < n; i++) {
+        size_t victim = (start + i) % n;
+        if (victim == worker || shards_[victim]->size() == 0) {
+            continue;
+        }
+        if (shards_[victim]->tryPop(task_out)) {
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingQueue::shutdown() {
+    stop_.store(true, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(park_lock_);
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+size_t WorkStealingQueue::size() const {
+    size_t total = 0;
+    for (auto& shard : shards_) {
+        total += shard->size();
+    }
+    return total;
+}
+
+void WorkStealingQueue::wake(std::condition_variable& cond, std::atomic<int>& idle) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(park_lock_);
+        cond.notify_one();
+    }
+}
@@ -7,9 +7,14 @@ DataType stringToDataType(const std::string& str) {
     else if (s == "int8") return INT8;
     else if (s == "uint8") return UINT8;
     else if (s == "float16") return FLOAT16;
+    else if (s == "bfloat16") return BFLOAT16;
     else assert(0);
 }
 
+bool isDataTypeName(const std::string& str) {
+    return str == "float32" || str == "int8" || str == "uint8" || str == "float16" || str == "bfloat16";
+}
+
 std::vector<uint16_t> bytesToUint16(const std::vector<uint8_t>& bytes) {
     assert(bytes.size() % 2 == 0);
 
@@ -35,6 +40,28 @@ std::vector<float> bytesToFloat32(const std::vector<uint8_t>& bytes) {
     return result;
 }
 
+std::vector<uint16_t> bytesToUint16(const Tensor& tensor) {
+    assert(tensor.size() % 2 == 0);
+    auto ptr = tensor.as<uint16_t>();
+    return std::vector<uint16_t>(ptr, ptr + tensor.size() / 2);
+}
+
+std::vector<float> bytesToFloat32(const Tensor& tensor) {
+    assert(tensor.size() % 4 == 0);
+    auto ptr = tensor.as<float>();
+    return std::vector<float>(ptr, ptr + tensor.size() / 4);
+}
+
+std::vector<float> tensorToFloat32(const Tensor& tensor, QuantParam q) {
+    if (tensor.dataType() == FLOAT32) {
+        return bytesToFloat32(tensor);
+    }
+    size_t count = tensor.size() / tensor.getElementSize(tensor.dataType());
+    std::vector<float> result(count);
+    convertBuffer(tensor.data(), tensor.dataType(), result.data(), FLOAT32, count, q);
+    return result;
+}
+
 std::vector<int> top5Indices(const std::vector<float>& res) {
     // 构造索引数组 [0, 1, 2, ..., N-1]
     std::vector<int> indices(res.size());